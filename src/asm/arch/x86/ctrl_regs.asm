@@ -108,6 +108,32 @@ _x86_WRMSR:
         wrmsr
         ret
 
+global _x86_RDTSC
+_x86_RDTSC:
+        ;; Lower bits in EAX, higher in EDX, fine to ret like this
+        rdtsc
+        ret
+
+;; Interrupts are never enabled in the bootstrapper, so these do not
+;; need to disable them around an MTRR update
+global _x86_cache_disable
+_x86_cache_disable:
+        ;; CR0.CD = 1, CR0.NW = 0
+        mov eax, cr0
+        or eax, 1 << 30
+        and eax, ~(1 << 29)
+        mov cr0, eax
+        wbinvd
+        ret
+
+global _x86_cache_enable
+_x86_cache_enable:
+        wbinvd
+        mov eax, cr0
+        and eax, ~(1 << 30)
+        mov cr0, eax
+        ret
+
 section .bss
 global _x86_CR0
 global _x86_CR1
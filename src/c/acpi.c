@@ -0,0 +1,375 @@
+/**
+ * @file acpi.c
+ *
+ * @author awewsomegamer <awewsomegamer@gmail.com>
+ *
+ * @LICENSE
+ * Arctan-OS/BSP-GRUB - GRUB bootstrapper for Arctan-OS/Kernel
+ * Copyright (C) 2023-2025 awewsomegamer
+ *
+ * This file is part of Arctan-OS/BSP-GRUB
+ *
+ * Arctan is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 2
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ * @DESCRIPTION
+ * Functions for walking the ACPI tables once and summarising the ones the
+ * kernel needs early.
+*/
+#define ARC_DEBUG_SUBSYS ARC_DEBUG_SUBSYS_ACPI
+
+#include <acpi.h>
+#include <global.h>
+#include <inttypes.h>
+#include <mm/watermark.h>
+#include <util.h>
+
+#define SDT_HEADER_SIZE 36
+
+#define MADT_LAPIC 0
+#define MADT_LAPIC_OVERRIDE 5
+#define MADT_X2APIC 9
+
+// Smallest length of each entry type which is decoded
+#define MADT_LAPIC_SIZE 8
+#define MADT_LAPIC_OVERRIDE_SIZE 12
+#define MADT_X2APIC_SIZE 16
+
+#define SRAT_LAPIC 0
+#define SRAT_MEMORY 1
+#define SRAT_X2APIC 2
+
+#define SRAT_LAPIC_SIZE 16
+#define SRAT_MEMORY_SIZE 40
+#define SRAT_X2APIC_SIZE 24
+
+struct acpi_rsdp {
+	char signature[8];
+	uint8_t checksum;
+	char oem_id[6];
+	uint8_t revision;
+	uint32_t rsdt;
+	// Revision 2 and later
+	uint32_t length;
+	uint64_t xsdt;
+	uint8_t extended_checksum;
+	uint8_t reserved[3];
+}__attribute__((packed));
+
+struct acpi_sdt {
+	char signature[4];
+	uint32_t length;
+	uint8_t revision;
+	uint8_t checksum;
+	char oem_id[6];
+	char oem_table_id[8];
+	uint32_t oem_revision;
+	uint32_t creator_id;
+	uint32_t creator_revision;
+}__attribute__((packed));
+
+static uint8_t acpi_checksum(uint8_t *data, uint32_t length) {
+	uint8_t sum = 0;
+
+	for (uint32_t i = 0; i < length; i++) {
+		sum += data[i];
+	}
+
+	return sum;
+}
+
+static int acpi_readable(uint64_t phys, uint64_t length) {
+	return phys != 0 && phys + length <= (uint64_t)UINT32_MAX + 1;
+}
+
+static struct acpi_sdt *acpi_find(struct ARC_ACPITable *tables, uint32_t count, char *signature) {
+	for (uint32_t i = 0; i < count; i++) {
+		if ((tables[i].flags & (1 << ARC_ACPI_TABLE_VALID)) && strncmp((char *)tables[i].signature, signature, 4) == 0) {
+			return (struct acpi_sdt *)(uintptr_t)tables[i].phys;
+		}
+	}
+
+	return NULL;
+}
+
+/**
+ * Walk the MADT, filling in out if it is not NULL.
+ *
+ * @return Number of LAPICs.
+ * */
+static uint32_t acpi_madt_lapics(struct acpi_sdt *madt, struct ARC_ACPILapic *out) {
+	uint8_t *entry = (uint8_t *)madt + SDT_HEADER_SIZE + 8;
+	uint8_t *end = (uint8_t *)madt + madt->length;
+	uint32_t count = 0;
+
+	while (entry + 2 <= end && entry[1] >= 2 && entry + entry[1] <= end) {
+		switch (entry[0]) {
+			case MADT_LAPIC: {
+				if (entry[1] < MADT_LAPIC_SIZE) {
+					break;
+				}
+
+				if (out != NULL) {
+					out[count].processor_uid = entry[2];
+					out[count].apic_id = entry[3];
+					out[count].flags = *(uint32_t *)(entry + 4);
+					out[count].domain = 0;
+				}
+
+				count++;
+				break;
+			}
+
+			case MADT_X2APIC: {
+				if (entry[1] < MADT_X2APIC_SIZE) {
+					break;
+				}
+
+				if (out != NULL) {
+					out[count].apic_id = *(uint32_t *)(entry + 4);
+					out[count].flags = *(uint32_t *)(entry + 8);
+					out[count].processor_uid = *(uint32_t *)(entry + 12);
+					out[count].domain = 0;
+				}
+
+				count++;
+				break;
+			}
+
+			case MADT_LAPIC_OVERRIDE: {
+				if (entry[1] < MADT_LAPIC_OVERRIDE_SIZE) {
+					break;
+				}
+
+				Arc_KernelMeta.acpi.lapic_base = *(uint64_t *)(entry + 4);
+				break;
+			}
+		}
+
+		entry += entry[1];
+	}
+
+	return count;
+}
+
+/**
+ * Walk the SRAT, filling in out if it is not NULL and setting the
+ * domain of the given LAPICs.
+ *
+ * @return Number of memory affinity ranges.
+ * */
+static uint32_t acpi_srat_ranges(struct acpi_sdt *srat, struct ARC_ACPISrat *out, struct ARC_ACPILapic *lapics, uint32_t lapic_count) {
+	uint8_t *entry = (uint8_t *)srat + SDT_HEADER_SIZE + 12;
+	uint8_t *end = (uint8_t *)srat + srat->length;
+	uint32_t count = 0;
+
+	while (entry + 2 <= end && entry[1] >= 2 && entry + entry[1] <= end) {
+		uint32_t apic_id = 0;
+		uint32_t domain = 0;
+		int is_cpu = 0;
+
+		switch (entry[0]) {
+			case SRAT_LAPIC: {
+				if (entry[1] < SRAT_LAPIC_SIZE) {
+					break;
+				}
+
+				apic_id = entry[3];
+				domain = entry[2] | (entry[9] << 8) | (entry[10] << 16) | (entry[11] << 24);
+				is_cpu = *(uint32_t *)(entry + 4) & 1;
+				break;
+			}
+
+			case SRAT_X2APIC: {
+				if (entry[1] < SRAT_X2APIC_SIZE) {
+					break;
+				}
+
+				domain = *(uint32_t *)(entry + 4);
+				apic_id = *(uint32_t *)(entry + 8);
+				is_cpu = *(uint32_t *)(entry + 12) & 1;
+				break;
+			}
+
+			case SRAT_MEMORY: {
+				if (entry[1] < SRAT_MEMORY_SIZE) {
+					break;
+				}
+
+				if (out != NULL) {
+					out[count].domain = *(uint32_t *)(entry + 2);
+					out[count].base = *(uint64_t *)(entry + 8);
+					out[count].len = *(uint64_t *)(entry + 16);
+					out[count].flags = *(uint32_t *)(entry + 28);
+				}
+
+				count++;
+				break;
+			}
+		}
+
+		for (uint32_t i = 0; is_cpu && lapics != NULL && i < lapic_count; i++) {
+			if (lapics[i].apic_id == apic_id) {
+				lapics[i].domain = domain;
+			}
+		}
+
+		entry += entry[1];
+	}
+
+	return count;
+}
+
+static void acpi_summarise(struct ARC_ACPITable *tables, uint32_t count) {
+	struct acpi_sdt *madt = acpi_find(tables, count, "APIC");
+	struct acpi_sdt *hpet = acpi_find(tables, count, "HPET");
+	struct acpi_sdt *mcfg = acpi_find(tables, count, "MCFG");
+	struct acpi_sdt *srat = acpi_find(tables, count, "SRAT");
+
+	struct ARC_ACPILapic *lapics = NULL;
+	uint32_t lapic_count = 0;
+
+	if (madt != NULL && madt->length >= SDT_HEADER_SIZE + 8) {
+		Arc_KernelMeta.acpi.lapic_base = *(uint32_t *)((uint8_t *)madt + SDT_HEADER_SIZE);
+		lapic_count = acpi_madt_lapics(madt, NULL);
+		lapics = alloc(lapic_count * sizeof(struct ARC_ACPILapic));
+
+		if (lapics != NULL) {
+			acpi_madt_lapics(madt, lapics);
+			Arc_KernelMeta.acpi.lapics = (uintptr_t)lapics;
+			Arc_KernelMeta.acpi.lapic_count = lapic_count;
+		}
+
+		ARC_DEBUG(INFO, "MADT: %d LAPICs, base 0x%"PRIx64"\n", lapic_count, Arc_KernelMeta.acpi.lapic_base);
+	}
+
+	if (hpet != NULL && hpet->length >= SDT_HEADER_SIZE + 20) {
+		// Address of the generic address structure following the block ID
+		Arc_KernelMeta.acpi.hpet_base = *(uint64_t *)((uint8_t *)hpet + SDT_HEADER_SIZE + 8);
+		ARC_DEBUG(INFO, "HPET: 0x%"PRIx64"\n", Arc_KernelMeta.acpi.hpet_base);
+	}
+
+	if (mcfg != NULL && mcfg->length >= SDT_HEADER_SIZE + 8) {
+		uint32_t mcfg_count = (mcfg->length - SDT_HEADER_SIZE - 8) / 16;
+		struct ARC_ACPIMcfg *segments = alloc(mcfg_count * sizeof(struct ARC_ACPIMcfg));
+		uint8_t *entry = (uint8_t *)mcfg + SDT_HEADER_SIZE + 8;
+
+		for (uint32_t i = 0; segments != NULL && i < mcfg_count; i++, entry += 16) {
+			segments[i].base = *(uint64_t *)entry;
+			segments[i].segment = *(uint16_t *)(entry + 8);
+			segments[i].bus_start = entry[10];
+			segments[i].bus_end = entry[11];
+		}
+
+		if (segments != NULL) {
+			Arc_KernelMeta.acpi.mcfg = (uintptr_t)segments;
+			Arc_KernelMeta.acpi.mcfg_count = mcfg_count;
+		}
+
+		ARC_DEBUG(INFO, "MCFG: %d segments\n", mcfg_count);
+	}
+
+	if (srat != NULL && srat->length >= SDT_HEADER_SIZE + 12) {
+		uint32_t srat_count = acpi_srat_ranges(srat, NULL, NULL, 0);
+		struct ARC_ACPISrat *ranges = alloc(srat_count * sizeof(struct ARC_ACPISrat));
+
+		if (ranges != NULL) {
+			acpi_srat_ranges(srat, ranges, lapics, lapics != NULL ? lapic_count : 0);
+			Arc_KernelMeta.acpi.srat = (uintptr_t)ranges;
+			Arc_KernelMeta.acpi.srat_count = srat_count;
+		}
+
+		ARC_DEBUG(INFO, "SRAT: %d memory ranges\n", srat_count);
+	}
+}
+
+int init_acpi() {
+	struct acpi_rsdp *rsdp = (struct acpi_rsdp *)(uintptr_t)Arc_KernelMeta.rsdp;
+
+	if (rsdp == NULL) {
+		ARC_DEBUG(WARN, "No RSDP, not walking ACPI tables\n");
+		return 0;
+	}
+
+	if (strncmp(rsdp->signature, "RSD PTR ", 8) != 0 || acpi_checksum((uint8_t *)rsdp, 20) != 0) {
+		ARC_DEBUG(ERR, "Bad RSDP\n");
+		return -1;
+	}
+
+	// Prefer the XSDT, its entries are 64-bit
+	uint64_t root = rsdp->rsdt;
+	uint32_t entry_size = 4;
+
+	if (rsdp->revision >= 2 && rsdp->xsdt != 0 && rsdp->length >= sizeof(struct acpi_rsdp)
+	    && acpi_checksum((uint8_t *)rsdp, rsdp->length) == 0) {
+		root = rsdp->xsdt;
+		entry_size = 8;
+	}
+
+	if (!acpi_readable(root, SDT_HEADER_SIZE)) {
+		ARC_DEBUG(ERR, "Root table at 0x%"PRIx64" is out of reach\n", root);
+		return -1;
+	}
+
+	struct acpi_sdt *sdt = (struct acpi_sdt *)(uintptr_t)root;
+
+	// A length of 0 passes the checksum, but would underflow the entry count
+	if (sdt->length < SDT_HEADER_SIZE || !acpi_readable(root, sdt->length)
+	    || acpi_checksum((uint8_t *)sdt, sdt->length) != 0) {
+		ARC_DEBUG(ERR, "Bad root table %.4s\n", sdt->signature);
+		return -1;
+	}
+
+	uint32_t count = (sdt->length - SDT_HEADER_SIZE) / entry_size;
+	struct ARC_ACPITable *tables = alloc(count * sizeof(struct ARC_ACPITable));
+
+	if (tables == NULL) {
+		ARC_DEBUG(ERR, "Failed to allocate ACPI directory\n");
+		return -1;
+	}
+
+	uint8_t *entries = (uint8_t *)sdt + SDT_HEADER_SIZE;
+
+	for (uint32_t i = 0; i < count; i++) {
+		uint64_t phys = entry_size == 8 ? *(uint64_t *)(entries + i * 8) : *(uint32_t *)(entries + i * 4);
+
+		memset(&tables[i], 0, sizeof(struct ARC_ACPITable));
+		tables[i].phys = phys;
+
+		if (!acpi_readable(phys, SDT_HEADER_SIZE)) {
+			ARC_DEBUG(WARN, "Table at 0x%"PRIx64" is out of reach, not verified\n", phys);
+			continue;
+		}
+
+		struct acpi_sdt *table = (struct acpi_sdt *)(uintptr_t)phys;
+
+		memcpy(tables[i].signature, table->signature, 4);
+		tables[i].length = table->length;
+
+		if (table->length >= SDT_HEADER_SIZE && acpi_readable(phys, table->length)
+		    && acpi_checksum((uint8_t *)table, table->length) == 0) {
+			tables[i].flags |= 1 << ARC_ACPI_TABLE_VALID;
+		} else {
+			ARC_DEBUG(WARN, "Table %.4s at 0x%"PRIx64" failed its checksum\n", table->signature, phys);
+		}
+	}
+
+	Arc_KernelMeta.acpi.tables = (uintptr_t)tables;
+	Arc_KernelMeta.acpi.table_count = count;
+
+	ARC_DEBUG(INFO, "ACPI: %d tables from %.4s\n", count, sdt->signature);
+
+	acpi_summarise(tables, count);
+
+	return 0;
+}
@@ -25,6 +25,8 @@
  * @DESCRIPTION
  * x86(-64) specific implementation of arch/cpuid.h
 */
+#define ARC_DEBUG_SUBSYS ARC_DEBUG_SUBSYS_ARCH
+
 #if defined(ARC_TARGET_ARCH_X86_64) || defined(ARC_TARGET_ARCH_X86)
 
 #include <arch/cpuid.h>
@@ -32,6 +34,7 @@
 #include <stdint.h>
 #include <global.h>
 #include <arch/x86/ctrl_regs.h>
+#include <arch/x86/mtrr.h>
 #include <inttypes.h>
 
 #define PAGE_ATTRIBUTE(n, val) (uint64_t)((uint64_t)(val & 0b111) << (n * 8))
@@ -78,6 +81,12 @@ int check_cpuid() {
                 _x86_WRMSR(0x277, msr);
         }
 
+	if (((edx >> 12) & 1) == 1) {
+		// Used to make the framebuffer write-combining
+		ARC_DEBUG(INFO, "MTRRs present\n");
+		mtrr_detect();
+	}
+
 	__cpuid(0x80000000, eax, ebx, ecx, edx);
 
 	uint32_t max_extended_value = eax;
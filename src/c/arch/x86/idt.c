@@ -25,6 +25,8 @@
  * @DESCRIPTION
  * Simple IDT to handle errors which may occur when getting to the kernel.
 */
+#define ARC_DEBUG_SUBSYS ARC_DEBUG_SUBSYS_ARCH
+
 #if defined(ARC_TARGET_ARCH_X86_64) || defined(ARC_TARGET_ARCH_X86)
 
 #include <arch/x86/idt.h>
@@ -36,6 +36,7 @@
 #include <arch/x86/gdt.h>
 #include <arch/x86/idt.h>
 #include <arch/cpuid.h>
+#include <arch/x86/mtrr.h>
 
 int init_arch(uint8_t *mb2i) {
 	init_gdt();
@@ -44,4 +45,14 @@ int init_arch(uint8_t *mb2i) {
         return 0;
 }
 
+int init_arch_fb() {
+	if (Arc_BootMeta.term.base == 0) {
+		return 0;
+	}
+
+	uint64_t size = (uint64_t)Arc_BootMeta.term.pitch * Arc_BootMeta.term.height;
+
+	return mtrr_set_wc(Arc_BootMeta.term.base, size);
+}
+
 #endif
\ No newline at end of file
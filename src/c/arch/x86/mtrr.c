@@ -0,0 +1,190 @@
+/**
+ * @file mtrr.c
+ *
+ * @author awewsomegamer <awewsomegamer@gmail.com>
+ *
+ * @LICENSE
+ * Arctan-OS/BSP-GRUB - GRUB bootstrapper for Arctan-OS/Kernel
+ * Copyright (C) 2023-2025 awewsomegamer
+ *
+ * This file is part of Arctan-OS/BSP-GRUB
+ *
+ * Arctan is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 2
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ * @DESCRIPTION
+ * Detection and programming of the x86 memory type range registers.
+ * 
+ * The bootstrapper runs unpaged, so the MTRRs alone decide the memory
+ * type of the framebuffer while it draws to it.
+*/
+#define ARC_DEBUG_SUBSYS ARC_DEBUG_SUBSYS_ARCH
+
+#if defined(ARC_TARGET_ARCH_X86_64) || defined(ARC_TARGET_ARCH_X86)
+
+#include <arch/x86/mtrr.h>
+#include <arch/x86/ctrl_regs.h>
+#include <cpuid.h>
+#include <global.h>
+#include <inttypes.h>
+
+#define MSR_MTRRCAP 0xFE
+#define MSR_MTRR_DEF_TYPE 0x2FF
+#define MSR_MTRR_PHYSBASE(__n) (0x200 + (__n) * 2)
+#define MSR_MTRR_PHYSMASK(__n) (0x201 + (__n) * 2)
+
+#define MTRR_TYPE_UC 0
+#define MTRR_TYPE_WC 1
+#define MTRR_VALID (1 << 11)
+#define MTRR_ENABLE (1 << 11)
+
+#define MTRR_MAX_VAR 32
+
+// Variable MTRRs as last read, handed to the kernel
+static struct ARC_MTRRVar mtrr_vars[MTRR_MAX_VAR] = { 0 };
+static uint32_t mtrr_count = 0;
+static uint64_t mtrr_cap = 0;
+static uint64_t mtrr_def = 0;
+// Bits of a physical address
+static uint64_t phys_mask = 0;
+
+static void mtrr_snapshot() {
+	mtrr_def = _x86_RDMSR(MSR_MTRR_DEF_TYPE);
+
+	for (uint32_t i = 0; i < mtrr_count; i++) {
+		mtrr_vars[i].base = _x86_RDMSR(MSR_MTRR_PHYSBASE(i));
+		mtrr_vars[i].mask = _x86_RDMSR(MSR_MTRR_PHYSMASK(i));
+	}
+
+	Arc_KernelMeta.mtrr.cap = mtrr_cap;
+	Arc_KernelMeta.mtrr.def_type = mtrr_def;
+	Arc_KernelMeta.mtrr.vars = (uintptr_t)mtrr_vars;
+	Arc_KernelMeta.mtrr.count = mtrr_count;
+}
+
+int mtrr_detect() {
+	register uint32_t eax;
+	register uint32_t ebx;
+	register uint32_t ecx;
+	register uint32_t edx;
+
+	uint32_t phys_bits = 36;
+
+	__cpuid(0x80000000, eax, ebx, ecx, edx);
+
+	if (eax >= 0x80000008) {
+		__cpuid(0x80000008, eax, ebx, ecx, edx);
+		phys_bits = eax & 0xFF;
+	}
+
+	phys_mask = ((uint64_t)1 << phys_bits) - 1;
+
+	mtrr_cap = _x86_RDMSR(MSR_MTRRCAP);
+	mtrr_count = min((uint32_t)(mtrr_cap & 0xFF), (uint32_t)MTRR_MAX_VAR);
+
+	mtrr_snapshot();
+
+	ARC_DEBUG(INFO, "MTRRs: %d variable, WC %s, %s, default type %d\n", mtrr_count,
+		  ((mtrr_cap >> 10) & 1) ? "supported" : "unsupported",
+		  (mtrr_def & MTRR_ENABLE) ? "enabled" : "disabled", (int)(mtrr_def & 0xFF));
+
+	return 0;
+}
+
+int mtrr_set_wc(uint64_t base, uint64_t size) {
+	if (mtrr_count == 0 || ((mtrr_cap >> 10) & 1) == 0 || (mtrr_def & MTRR_ENABLE) == 0) {
+		ARC_DEBUG(INFO, "No write-combining MTRRs available\n");
+		return -1;
+	}
+
+	uint64_t start = base & ~((uint64_t)PAGE_SIZE - 1);
+	uint64_t end = ALIGN(base + size, (uint64_t)PAGE_SIZE);
+	int free[MTRR_MAX_VAR] = { 0 };
+	uint32_t free_count = 0;
+
+	for (uint32_t i = 0; i < mtrr_count; i++) {
+		if ((mtrr_vars[i].mask & MTRR_VALID) == 0) {
+			free[free_count++] = i;
+			continue;
+		}
+
+		uint64_t var_mask = mtrr_vars[i].mask & phys_mask & ~((uint64_t)PAGE_SIZE - 1);
+		uint64_t var_base = mtrr_vars[i].base & var_mask;
+		uint64_t var_end = var_base + (~var_mask & phys_mask) + 1;
+
+		if (var_end <= start || var_base >= end) {
+			continue;
+		}
+
+		// UC always wins over WC, and WC overlapping anything else is
+		// undefined, so leave the range alone
+		if ((mtrr_vars[i].base & 0xFF) == MTRR_TYPE_WC && var_base <= start && var_end >= end) {
+			ARC_DEBUG(INFO, "Framebuffer already write-combining (MTRR %d)\n", i);
+			return 0;
+		}
+
+		ARC_DEBUG(WARN, "MTRR %d (0x%"PRIx64" -> 0x%"PRIx64", type %d) overlaps 0x%"PRIx64" -> 0x%"PRIx64", not making it WC\n",
+			  i, var_base, var_end, (int)(mtrr_vars[i].base & 0xFF), start, end);
+
+		return -1;
+	}
+
+	// Split the range into naturally aligned power of two blocks
+	uint64_t blocks[MTRR_MAX_VAR] = { 0 };
+	uint64_t block_sizes[MTRR_MAX_VAR] = { 0 };
+	uint32_t block_count = 0;
+	uint64_t at = start;
+
+	while (at < end && block_count < free_count) {
+		uint64_t block = at & -at;
+
+		while (at + block > end) {
+			block >>= 1;
+		}
+
+		blocks[block_count] = at;
+		block_sizes[block_count] = block;
+		block_count++;
+
+		at += block;
+	}
+
+	if (block_count == 0) {
+		ARC_DEBUG(WARN, "No free MTRRs for the framebuffer\n");
+		return -1;
+	}
+
+	if (at < end) {
+		ARC_DEBUG(WARN, "Only 0x%"PRIx64" of 0x%"PRIx64" B of the framebuffer could be made WC\n", at - start, end - start);
+	}
+
+	// Intel SDM Vol. 3A, "MTRR Maintenance Programming Interface"
+	_x86_cache_disable();
+	_x86_WRMSR(MSR_MTRR_DEF_TYPE, mtrr_def & ~(uint64_t)MTRR_ENABLE);
+
+	for (uint32_t i = 0; i < block_count; i++) {
+		_x86_WRMSR(MSR_MTRR_PHYSBASE(free[i]), blocks[i] | MTRR_TYPE_WC);
+		_x86_WRMSR(MSR_MTRR_PHYSMASK(free[i]), (~(block_sizes[i] - 1) & phys_mask) | MTRR_VALID);
+	}
+
+	_x86_WRMSR(MSR_MTRR_DEF_TYPE, mtrr_def);
+	_x86_cache_enable();
+
+	mtrr_snapshot();
+
+	ARC_DEBUG(INFO, "Made 0x%"PRIx64" -> 0x%"PRIx64" write-combining using %d MTRR(s)\n", start, at, block_count);
+
+	return 0;
+}
+
+#endif
@@ -24,6 +24,8 @@
  *
  * @DESCRIPTION
 */
+#define ARC_DEBUG_SUBSYS ARC_DEBUG_SUBSYS_ARCH
+
 #if defined(ARC_TARGET_ARCH_X86_64) || defined(ARC_TARGET_ARCH_X86)
 
 #include <arctan.h>
@@ -212,10 +214,15 @@ static int pager_traverse(struct pager_traverse_info *info, int (*callback)(stru
 	}
 
 	while (info->size) {
+		// Large pages can only be used if both addresses are aligned to the page size
 		uint8_t can_gib = ((Arc_KernelMeta.paging_features >> ARC_PAGER_FLAG_1_GIB) & 1) 
-				   && (MASKED_READ(info->attributes, ARC_PAGER_4K, 1) == 0) && (info->size >= ONE_GIB); 
+				   && (Arc_BootTunables.page_policy >= ARC_BOOT_PAGES_1G)
+				   && (MASKED_READ(info->attributes, ARC_PAGER_4K, 1) == 0) && (info->size >= ONE_GIB)
+				   && ((info->virtual | info->physical) & (ONE_GIB - 1)) == 0;
 		uint8_t can_2mib = (info->size >= TWO_MIB) 
-				   && (MASKED_READ(info->attributes, ARC_PAGER_4K, 1) == 0);
+				   && (Arc_BootTunables.page_policy >= ARC_BOOT_PAGES_2M)
+				   && (MASKED_READ(info->attributes, ARC_PAGER_4K, 1) == 0)
+				   && ((info->virtual | info->physical) & (TWO_MIB - 1)) == 0;
 
 		MASKED_WRITE(info->attributes, can_gib, ARC_PAGER_RESV0, 1);
 		MASKED_WRITE(info->attributes, can_2mib, ARC_PAGER_RESV1, 1);
@@ -0,0 +1,319 @@
+/**
+ * @file cmdline.c
+ *
+ * @author awewsomegamer <awewsomegamer@gmail.com>
+ *
+ * @LICENSE
+ * Arctan-OS/BSP-GRUB - GRUB bootstrapper for Arctan-OS/Kernel
+ * Copyright (C) 2023-2025 awewsomegamer
+ *
+ * This file is part of Arctan-OS/BSP-GRUB
+ *
+ * Arctan is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 2
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ * @DESCRIPTION
+ * Parser turning the kernel command line into the tunables used by the
+ * bootstrapper.
+*/
+#define ARC_DEBUG_SUBSYS ARC_DEBUG_SUBSYS_BOOT
+
+#include <boot/cmdline.h>
+#include <global.h>
+#include <inttypes.h>
+#include <stddef.h>
+
+#define CMDLINE_BOOL 0
+#define CMDLINE_SIZE 1
+#define CMDLINE_ENUM 2
+
+struct cmdline_option {
+	char *key;
+	int kind;
+	size_t offset;
+	size_t width;
+	// Values of an enum, the index is the value stored
+	const char **names;
+	int name_count;
+};
+
+static const char *page_names[] = {
+	[ARC_BOOT_PAGES_4K] = "4k",
+	[ARC_BOOT_PAGES_2M] = "2m",
+	[ARC_BOOT_PAGES_1G] = "1g",
+};
+
+static const char *log_names[] = {
+	[ARC_BOOT_LOG_ERR] = "err",
+	[ARC_BOOT_LOG_WARN] = "warn",
+	[ARC_BOOT_LOG_INFO] = "info",
+};
+
+// Indexed by the bit of the ARC_DEBUG_SUBSYS_* value
+static const char *subsys_names[ARC_DEBUG_SUBSYS_COUNT] = {
+	"core", "boot", "mm", "arch", "elf", "acpi",
+};
+
+#define CMDLINE_FIELD(__field) offsetof(struct ARC_BootTunables, __field), sizeof(((struct ARC_BootTunables *)0)->__field)
+
+// bsp.log.<subsystem>=
+#define CMDLINE_SUBSYS_PREFIX "log."
+static const struct cmdline_option subsys_option = { CMDLINE_SUBSYS_PREFIX, CMDLINE_ENUM, 0, 0, log_names, 3 };
+
+static const struct cmdline_option options[] = {
+	{ "pages", CMDLINE_ENUM, CMDLINE_FIELD(page_policy), page_names, 3 },
+	{ "log", CMDLINE_ENUM, CMDLINE_FIELD(log_level), log_names, 3 },
+	{ "fb", CMDLINE_BOOL, CMDLINE_FIELD(framebuffer), NULL, 0 },
+	{ "fb.scale", CMDLINE_SIZE, CMDLINE_FIELD(fb_scale), NULL, 0 },
+	{ "splash", CMDLINE_BOOL, CMDLINE_FIELD(splash), NULL, 0 },
+	{ "hhdm", CMDLINE_SIZE, CMDLINE_FIELD(hhdm_size), NULL, 0 },
+	{ "kernel.contiguous", CMDLINE_BOOL, CMDLINE_FIELD(kernel_contiguous), NULL, 0 },
+	{ "initramfs.relocate", CMDLINE_BOOL, CMDLINE_FIELD(initramfs_relocate), NULL, 0 },
+};
+
+#ifndef ARC_BSP_LOG_LEVEL
+#define ARC_BSP_LOG_LEVEL ARC_BOOT_LOG_WARN
+#endif
+
+struct ARC_BootTunables Arc_BootTunables = {
+	.page_policy = ARC_BOOT_PAGES_1G,
+	.log_level = ARC_BSP_LOG_LEVEL,
+	.framebuffer = 1,
+	.hhdm_size = 0,
+#ifdef ARC_BSP_KERNEL_CONTIGUOUS
+	.kernel_contiguous = 1,
+#endif
+#ifdef ARC_BSP_INITRAMFS_RELOCATE
+	.initramfs_relocate = 1,
+#endif
+#ifdef ARC_BSP_SPLASH
+	.splash = 1,
+#endif
+};
+
+#define CMDLINE_LOG_MASK(__level) ((__level) <= ARC_BSP_LOG_LEVEL ? 0xFFFFFFFF : 0)
+
+// Messages before the command line is parsed follow the default level
+uint32_t Arc_BootLogMask[ARC_BOOT_LOG_INFO + 1] = {
+	[ARC_BOOT_LOG_ERR] = CMDLINE_LOG_MASK(ARC_BOOT_LOG_ERR),
+	[ARC_BOOT_LOG_WARN] = CMDLINE_LOG_MASK(ARC_BOOT_LOG_WARN),
+	[ARC_BOOT_LOG_INFO] = CMDLINE_LOG_MASK(ARC_BOOT_LOG_INFO),
+};
+
+// Level set for each subsystem plus one, 0 follows bsp.log=
+static uint32_t subsys_levels[ARC_DEBUG_SUBSYS_COUNT] = { 0 };
+
+static int cmdline_match(char *a, size_t a_len, const char *b) {
+	size_t i = 0;
+
+	for (; i < a_len && b[i] != 0; i++) {
+		if (a[i] != b[i]) {
+			return 0;
+		}
+	}
+
+	return i == a_len && b[i] == 0;
+}
+
+static int cmdline_value(const struct cmdline_option *option, char *value, size_t len, uint64_t *out) {
+	switch (option->kind) {
+		case CMDLINE_BOOL: {
+			if (value == NULL || cmdline_match(value, len, "on") || cmdline_match(value, len, "1")) {
+				*out = 1;
+				return 0;
+			}
+
+			if (cmdline_match(value, len, "off") || cmdline_match(value, len, "0")) {
+				*out = 0;
+				return 0;
+			}
+
+			return -1;
+		}
+
+		case CMDLINE_SIZE: {
+			if (value == NULL || len == 0) {
+				return -1;
+			}
+
+			uint64_t size = 0;
+			size_t i = 0;
+
+			for (; i < len && value[i] >= '0' && value[i] <= '9'; i++) {
+				size = size * 10 + (value[i] - '0');
+			}
+
+			if (i == 0 || len - i > 1) {
+				return -1;
+			}
+
+			if (i < len) {
+				switch (value[i] | 0x20) {
+					case 'k': { size <<= 10; break; }
+					case 'm': { size <<= 20; break; }
+					case 'g': { size <<= 30; break; }
+					default: { return -1; }
+				}
+			}
+
+			*out = size;
+			return 0;
+		}
+
+		case CMDLINE_ENUM: {
+			if (value == NULL) {
+				return -1;
+			}
+
+			for (int i = 0; i < option->name_count; i++) {
+				if (cmdline_match(value, len, option->names[i])) {
+					*out = i;
+					return 0;
+				}
+			}
+
+			return -1;
+		}
+	}
+
+	return -1;
+}
+
+static int cmdline_apply_subsys(char *name, size_t name_len, char *value, size_t value_len) {
+	for (int i = 0; i < ARC_DEBUG_SUBSYS_COUNT; i++) {
+		if (!cmdline_match(name, name_len, subsys_names[i])) {
+			continue;
+		}
+
+		uint64_t level = 0;
+
+		if (cmdline_value(&subsys_option, value, value_len, &level) != 0) {
+			return -1;
+		}
+
+		subsys_levels[i] = level + 1;
+
+		return 0;
+	}
+
+	return -1;
+}
+
+static int cmdline_apply(char *key, size_t key_len, char *value, size_t value_len) {
+	size_t subsys_len = sizeof(CMDLINE_SUBSYS_PREFIX) - 1;
+
+	if (key_len > subsys_len && strncmp(key, CMDLINE_SUBSYS_PREFIX, subsys_len) == 0) {
+		return cmdline_apply_subsys(key + subsys_len, key_len - subsys_len, value, value_len);
+	}
+
+	for (size_t i = 0; i < sizeof(options) / sizeof(*options); i++) {
+		const struct cmdline_option *option = &options[i];
+
+		if (!cmdline_match(key, key_len, option->key)) {
+			continue;
+		}
+
+		uint64_t parsed = 0;
+
+		if (cmdline_value(option, value, value_len, &parsed) != 0) {
+			return -1;
+		}
+
+		uint8_t *field = (uint8_t *)&Arc_BootTunables + option->offset;
+
+		if (option->width == sizeof(uint64_t)) {
+			*(uint64_t *)field = parsed;
+		} else {
+			*(uint32_t *)field = (uint32_t)parsed;
+		}
+
+		return 0;
+	}
+
+	return -1;
+}
+
+int cmdline_parse(char *cmdline) {
+	int errors = 0;
+
+	Arc_KernelMeta.cmdline = (uintptr_t)cmdline;
+
+	if (cmdline == NULL) {
+		return 0;
+	}
+
+	char *c = cmdline;
+
+	while (*c != 0) {
+		// Find the bounds of the next option
+		while (*c == ' ' || *c == '\t') {
+			c++;
+		}
+
+		char *option = c;
+
+		while (*c != 0 && *c != ' ' && *c != '\t') {
+			c++;
+		}
+
+		size_t len = c - option;
+		size_t prefix = sizeof(ARC_BSP_CMDLINE_PREFIX) - 1;
+
+		if (len <= prefix || strncmp(option, ARC_BSP_CMDLINE_PREFIX, prefix) != 0) {
+			continue;
+		}
+
+		char *key = option + prefix;
+		size_t key_len = 0;
+
+		while (key_len < len - prefix && key[key_len] != '=') {
+			key_len++;
+		}
+
+		char *value = NULL;
+		size_t value_len = 0;
+
+		if (key_len < len - prefix) {
+			value = key + key_len + 1;
+			value_len = len - prefix - key_len - 1;
+		}
+
+		if (cmdline_apply(key, key_len, value, value_len) != 0) {
+			ARC_DEBUG(WARN, "Ignoring bad option %.*s\n", (int)len, option);
+			errors++;
+		}
+	}
+
+	// Fold the levels into the masks ARC_DEBUG checks, so filtering costs
+	// a single test
+	for (int level = ARC_BOOT_LOG_WARN; level <= ARC_BOOT_LOG_INFO; level++) {
+		uint32_t mask = 0;
+
+		for (int i = 0; i < ARC_DEBUG_SUBSYS_COUNT; i++) {
+			uint32_t subsys = subsys_levels[i] ? subsys_levels[i] - 1 : Arc_BootTunables.log_level;
+
+			if (subsys >= (uint32_t)level) {
+				mask |= 1 << i;
+			}
+		}
+
+		Arc_BootLogMask[level] = mask;
+	}
+
+	ARC_DEBUG(INFO, "Tunables: pages=%s log=%s fb=%d fb.scale=%d splash=%d hhdm=0x%"PRIx64" kernel.contiguous=%d initramfs.relocate=%d (warn mask 0x%x, info mask 0x%x)\n",
+		  page_names[Arc_BootTunables.page_policy], log_names[Arc_BootTunables.log_level], Arc_BootTunables.framebuffer, Arc_BootTunables.fb_scale, Arc_BootTunables.splash,
+		  Arc_BootTunables.hhdm_size, Arc_BootTunables.kernel_contiguous, Arc_BootTunables.initramfs_relocate,
+		  Arc_BootLogMask[ARC_BOOT_LOG_WARN], Arc_BootLogMask[ARC_BOOT_LOG_INFO]);
+
+	return errors;
+}
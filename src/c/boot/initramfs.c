@@ -0,0 +1,258 @@
+/**
+ * @file initramfs.c
+ *
+ * @author awewsomegamer <awewsomegamer@gmail.com>
+ *
+ * @LICENSE
+ * Arctan-OS/BSP-GRUB - GRUB bootstrapper for Arctan-OS/Kernel
+ * Copyright (C) 2023-2025 awewsomegamer
+ *
+ * This file is part of Arctan-OS/BSP-GRUB
+ *
+ * Arctan is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 2
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ * @DESCRIPTION
+ * Functions for preparing the initramfs for the kernel.
+*/
+#define ARC_DEBUG_SUBSYS ARC_DEBUG_SUBSYS_BOOT
+
+#include <boot/initramfs.h>
+#include <boot/module.h>
+#include <global.h>
+#include <inttypes.h>
+#include <mm/watermark.h>
+#include <mm/mmap.h>
+#include <arch/pager.h>
+#include <config.h>
+#include <util.h>
+
+#define TWO_MIB 0x200000
+
+#define CPIO_HEADER_SIZE 110
+#define CPIO_TRAILER "TRAILER!!!"
+
+// Field offsets in a newc header, each field is 8 ASCII hex digits
+#define CPIO_MAGIC 0
+#define CPIO_MODE 14
+#define CPIO_FILESIZE 54
+#define CPIO_NAMESIZE 94
+
+#define FNV_OFFSET_BASIS 0xCBF29CE484222325ULL
+#define FNV_PRIME 0x100000001B3ULL
+
+static uint32_t cpio_field(uint8_t *header, int offset) {
+	uint32_t value = 0;
+
+	for (int i = 0; i < 8; i++) {
+		uint8_t c = header[offset + i];
+		uint32_t digit = 0;
+
+		if (c >= '0' && c <= '9') {
+			digit = c - '0';
+		} else if (c >= 'a' && c <= 'f') {
+			digit = c - 'a' + 10;
+		} else if (c >= 'A' && c <= 'F') {
+			digit = c - 'A' + 10;
+		}
+
+		value = (value << 4) | digit;
+	}
+
+	return value;
+}
+
+static int cpio_is_header(uint8_t *header) {
+	// 070701 (newc) or 070702 (newc with checksums)
+	return strncmp((char *)header, "07070", 5) == 0 && (header[5] == '1' || header[5] == '2');
+}
+
+/**
+ * Walk the archive, filling in an index entry for each file if out
+ * is not NULL.
+ *
+ * @return Number of files in the archive, -1 if it is malformed.
+ * */
+static int cpio_walk(uint8_t *base, uint64_t size, struct ARC_InitramfsIndex *out) {
+	uint64_t offset = 0;
+	int count = 0;
+
+	while (offset + CPIO_HEADER_SIZE <= size) {
+		uint8_t *header = base + offset;
+
+		// Concatenated archives are separated by zero padding
+		if (*header == 0) {
+			offset += 4;
+			continue;
+		}
+
+		if (!cpio_is_header(header)) {
+			ARC_DEBUG(ERR, "Bad CPIO header at 0x%"PRIx64"\n", offset);
+			return -1;
+		}
+
+		uint32_t namesize = cpio_field(header, CPIO_NAMESIZE);
+		uint32_t filesize = cpio_field(header, CPIO_FILESIZE);
+		uint64_t data = ALIGN(offset + CPIO_HEADER_SIZE + namesize, 4);
+		char *name = (char *)(header + CPIO_HEADER_SIZE);
+
+		if (offset + CPIO_HEADER_SIZE + namesize > size || data + filesize > size) {
+			ARC_DEBUG(ERR, "CPIO entry at 0x%"PRIx64" runs past the archive\n", offset);
+			return -1;
+		}
+
+		// namesize includes the NUL terminator
+		uint32_t name_len = namesize > 0 ? namesize - 1 : 0;
+
+		if (name_len == sizeof(CPIO_TRAILER) - 1 && strncmp(name, CPIO_TRAILER, name_len) == 0) {
+			break;
+		}
+
+		if (out != NULL) {
+			out[count].hash = initramfs_hash(name, name_len);
+			out[count].header = offset;
+			out[count].data = data;
+			out[count].size = filesize;
+			out[count].mode = cpio_field(header, CPIO_MODE);
+		}
+
+		count++;
+		offset = ALIGN(data + filesize, 4);
+	}
+
+	return count;
+}
+
+static int initramfs_index_cmp(const void *a, const void *b) {
+	uint64_t x = ((struct ARC_InitramfsIndex *)a)->hash;
+	uint64_t y = ((struct ARC_InitramfsIndex *)b)->hash;
+
+	return (x > y) - (x < y);
+}
+
+uint64_t initramfs_hash(char *path, uint32_t len) {
+	// Make "./bin/init", "/bin/init" and "bin/init" hash the same
+	if (len >= 2 && path[0] == '.' && path[1] == '/') {
+		path += 2;
+		len -= 2;
+	}
+
+	while (len > 0 && *path == '/') {
+		path++;
+		len--;
+	}
+
+	uint64_t hash = FNV_OFFSET_BASIS;
+
+	for (uint32_t i = 0; i < len; i++) {
+		hash ^= (uint8_t)path[i];
+		hash *= FNV_PRIME;
+	}
+
+	return hash;
+}
+
+int initramfs_index() {
+	if (Arc_KernelMeta.initramfs.base == 0 || Arc_KernelMeta.initramfs.size == 0) {
+		return 0;
+	}
+
+	uint8_t *base = (uint8_t *)(uintptr_t)Arc_KernelMeta.initramfs.base;
+	uint64_t size = Arc_KernelMeta.initramfs.size;
+
+	int count = cpio_walk(base, size, NULL);
+
+	if (count <= 0) {
+		ARC_DEBUG(ERR, "Failed to index initramfs\n");
+		return -1;
+	}
+
+	struct ARC_InitramfsIndex *index = alloc(count * sizeof(struct ARC_InitramfsIndex));
+
+	if (index == NULL) {
+		ARC_DEBUG(ERR, "Failed to allocate initramfs index\n");
+		return -1;
+	}
+
+	cpio_walk(base, size, index);
+	hsort(index, count, sizeof(struct ARC_InitramfsIndex), initramfs_index_cmp);
+
+	Arc_KernelMeta.initramfs_index.base = (uintptr_t)index;
+	Arc_KernelMeta.initramfs_index.len = count;
+
+	ARC_DEBUG(INFO, "Indexed %d initramfs entries at %p\n", count, index);
+
+	return 0;
+}
+
+int initramfs_relocate(void *page_tables) {
+	struct ARC_BootModule *module = module_find_type(ARC_BOOT_MODULE_INITRAMFS);
+
+	if (module == NULL || module->size == 0) {
+		return 0;
+	}
+
+	uint64_t old_base = module->base;
+	uint64_t size = module->size;
+	uint64_t block_size = ALIGN(size, (uint64_t)TWO_MIB);
+
+	// Everything that is written to must be below 4 GiB, the watermark
+	// allocator only hands out such memory
+	void *block = alloc_aligned(block_size, TWO_MIB);
+
+	if (block == NULL) {
+		ARC_DEBUG(ERR, "No 2 MiB aligned block for 0x%"PRIx64" B initramfs\n", size);
+		return -1;
+	}
+
+	memcpy(block, (void *)(uintptr_t)old_base, size);
+	// Zero the tail so the whole block can be mapped
+	memset((uint8_t *)block + size, 0, block_size - size);
+
+	module->base = (uintptr_t)block;
+	Arc_KernelMeta.initramfs.base = module->base;
+
+	ARC_DEBUG(INFO, "Relocated initramfs 0x%"PRIx64" -> %p (0x%"PRIx64" B)\n", old_base, block, block_size);
+
+#ifdef ARC_INITRAMFS_VADDR
+	// Map the block into the window the kernel asked for, both addresses
+	// being 2 MiB aligned lets the pager use 2 MiB pages throughout
+	if (pager_map(page_tables, ARC_INITRAMFS_VADDR, module->base, block_size, 1 << ARC_PAGER_NX) != 0) {
+		ARC_DEBUG(ERR, "Failed to map initramfs at 0x%"PRIx64"\n", (uint64_t)ARC_INITRAMFS_VADDR);
+		return -1;
+	}
+
+	module->vaddr = ARC_INITRAMFS_VADDR;
+	module->vsize = block_size;
+#else
+	(void)page_tables;
+#endif
+
+	// Give back the pages GRUB placed the module in, as long as they
+	// are not shared with the tags which are handed to the kernel
+	uint64_t release_base = ALIGN(old_base, (uint64_t)PAGE_SIZE);
+	uint64_t release_end = (old_base + size) & ~((uint64_t)PAGE_SIZE - 1);
+	uint64_t tags_base = Arc_KernelMeta.boot.info.grub_tags;
+	uint64_t tags_end = tags_base + *(uint32_t *)(uintptr_t)tags_base;
+
+	if (release_base < tags_end && tags_base < release_end) {
+		ARC_DEBUG(WARN, "Initramfs shares memory with the MB2 tags, not releasing it\n");
+		return 0;
+	}
+
+	if (release_base < release_end && mmap_set_type(release_base, release_end - release_base, ARC_MEMORY_AVAILABLE) != 0) {
+		ARC_DEBUG(WARN, "Failed to release old initramfs memory\n");
+	}
+
+	return 0;
+}
@@ -25,10 +25,18 @@
  * @DESCRIPTION
  * Abstract freelist implementation.
 */
+#define ARC_DEBUG_SUBSYS ARC_DEBUG_SUBSYS_BOOT
+
 #include "util.h"
 #include <arctan.h>
 #include <boot/mb2parse.h>
+#include <boot/module.h>
+#include <boot/cmdline.h>
 #include <boot/multiboot2.h>
+#include <mm/mmap.h>
+#if defined(ARC_TARGET_ARCH_X86_64) || defined(ARC_TARGET_ARCH_X86)
+#include <arch/x86/ctrl_regs.h>
+#endif
 #include <global.h>
 #include <inttypes.h>
 #include <interface/terminal.h>
@@ -39,8 +47,74 @@ struct mb2_base_tag {
 	uint32_t size;
 }__attribute__((packed));
 
-struct ARC_MMap arc_mmap[512] = { 0 }; // This is a lot of memory map entries, if you have
-			               // a system that has more than this then good luck I guess
+// Number of MB2 tag types the directory and handler table can hold
+#define MB2_TAG_TYPE_COUNT (MULTIBOOT_TAG_TYPE_LOAD_BASE_ADDR + 1)
+
+// First tag of each type, filled in while walking the tags
+static struct mb2_base_tag *tag_directory[MB2_TAG_TYPE_COUNT] = { 0 };
+
+// Memory in use by the bootstrapper, the modules and anything else GRUB
+// loaded, laid over the ARC_MMap
+#define MB2_MAX_RESERVATIONS (ARC_BSP_MAX_MODULES + 32)
+static struct ARC_MMap reservations[MB2_MAX_RESERVATIONS] = { 0 };
+static int reservation_count = 0;
+
+// Span of the bootstrapper's allocated sections, if GRUB described them
+static uint64_t image_span = 0;
+
+#define ELF32_SHF_ALLOC 0x2
+
+struct elf32_shdr {
+	uint32_t sh_name;
+	uint32_t sh_type;
+	uint32_t sh_flags;
+	uint32_t sh_addr;
+	uint32_t sh_offset;
+	uint32_t sh_size;
+	uint32_t sh_link;
+	uint32_t sh_info;
+	uint32_t sh_addralign;
+	uint32_t sh_entsize;
+}__attribute__((packed));
+
+// EFI memory types, UEFI spec. 7.2
+#define EFI_RESERVED_MEMORY_TYPE 0
+#define EFI_LOADER_CODE 1
+#define EFI_LOADER_DATA 2
+#define EFI_BOOT_SERVICES_CODE 3
+#define EFI_BOOT_SERVICES_DATA 4
+#define EFI_RUNTIME_SERVICES_CODE 5
+#define EFI_RUNTIME_SERVICES_DATA 6
+#define EFI_CONVENTIONAL_MEMORY 7
+#define EFI_UNUSABLE_MEMORY 8
+#define EFI_ACPI_RECLAIM_MEMORY 9
+#define EFI_ACPI_MEMORY_NVS 10
+
+#define EFI_MEMORY_RUNTIME (1ULL << 63)
+#define EFI_PAGE_SIZE 0x1000
+
+struct efi_memory_descriptor {
+	uint32_t type;
+	uint32_t pad;
+	uint64_t physical_start;
+	uint64_t virtual_start;
+	uint64_t pages;
+	uint64_t attribute;
+}__attribute__((packed));
+
+// Regions the firmware needs mapped at runtime, handed to the kernel
+// so they can be mapped with the attributes EFI asked for
+#define ARC_EFI_MAX_RUNTIME 64
+static struct ARC_EFIRuntime efi_runtime[ARC_EFI_MAX_RUNTIME] = { 0 };
+
+// Firmware memory map the ARC_MMap is built from
+struct mb2_mmap_source {
+	struct multiboot_tag_efi_mmap *efi;
+	struct multiboot_tag_mmap *bios;
+	uint32_t count;
+	int bs_active;
+};
+
 /**
  * Converts a MB2 memory type to ARC type
  */
@@ -63,338 +137,671 @@ uint32_t mb2_MMType2Type(uint32_t mb2_type) {
 		}
 	}
 
-	ARC_DEBUG(ERR, "Unknown MB2 memory type: %d\n", mb2_type);
+	ARC_DEBUG(WARN, "Unknown MB2 memory type: %d, treating as reserved\n", mb2_type);
 
-	return -1;
+	return ARC_MEMORY_RESERVED;
 }
 
-int parse_mb2i(uint8_t *mb2i) {
-	// Get information from the fixed tag
-	uint32_t total_size = *(uint32_t *)mb2i;
+/**
+ * Converts an EFI memory type to ARC type
+ *
+ * Boot services and loader memory is only reclaimable once boot
+ * services have been exited.
+ */
+static uint32_t mb2_EFIType2Type(uint32_t efi_type, int bs_active) {
+	switch (efi_type) {
+		case EFI_CONVENTIONAL_MEMORY: {
+			return ARC_MEMORY_AVAILABLE;
+		}
+		case EFI_LOADER_CODE:
+		case EFI_LOADER_DATA:
+		case EFI_BOOT_SERVICES_CODE:
+		case EFI_BOOT_SERVICES_DATA: {
+			return bs_active ? ARC_MEMORY_RESERVED : ARC_MEMORY_AVAILABLE;
+		}
+		case EFI_ACPI_RECLAIM_MEMORY: {
+			return ARC_MEMORY_ACPI_RECLAIMABLE;
+		}
+		case EFI_ACPI_MEMORY_NVS: {
+			return ARC_MEMORY_NVS;
+		}
+		case EFI_UNUSABLE_MEMORY: {
+			return ARC_MEMORY_BADRAM;
+		}
+	}
 
-	if (total_size == 0) {
-		ARC_DEBUG(ERR, "Given MB2I's size is 0\n");
+	// Runtime services, MMIO, PAL code, persistent memory and
+	// anything newer than this list
+	return ARC_MEMORY_RESERVED;
+}
+
+/**
+ * Reserve the pages covering [base, end) in the ARC_MMap.
+ *
+ * @return Error code (0: success).
+ * */
+static int mb2_reserve(uint64_t base, uint64_t end, uint32_t type) {
+	if (end <= base) {
+		return 0;
+	}
+
+	if (reservation_count >= MB2_MAX_RESERVATIONS) {
+		ARC_DEBUG(ERR, "Out of reservations, 0x%"PRIx64" -> 0x%"PRIx64" not reserved\n", base, end);
 		return -1;
 	}
 
-	Arc_KernelMeta.boot.proc = ARC_BOOTPROC_MB2;
-	Arc_KernelMeta.boot.info.grub_tags = (uint64_t)mb2i;
+	base &= ~((uint64_t)PAGE_SIZE - 1);
+	end = ALIGN(end, (uint64_t)PAGE_SIZE);
 
-	// Start at first 8-byte aligned tag
-	uint32_t offset = 8;
+	reservations[reservation_count].base = base;
+	reservations[reservation_count].len = end - base;
+	reservations[reservation_count].type = type;
+	reservation_count++;
 
-	ARC_DEBUG(INFO, "Parsing Multiboot2 tags\n");
+	return 0;
+}
 
-	// First look for information like the framebuffer and modules
-	// so that there is a way to display erros and such to the user
-	// and look for modules / address related things which would
-	// help calculate bootstrap_end_phys
-	struct multiboot_tag_framebuffer *fb_tag = NULL;
-	uintptr_t bootstrap_begin_phys = 0;
-	uintptr_t bootstrap_end_phys = 0;
+void *mb2_get_tag(uint32_t type) {
+	if (type >= MB2_TAG_TYPE_COUNT) {
+		return NULL;
+	}
 
-	while (offset < total_size) {
-		struct mb2_base_tag *tag = (struct mb2_base_tag *)(mb2i + offset);
+	return tag_directory[type];
+}
 
-		switch (tag->type) {
-			case MULTIBOOT_TAG_TYPE_FRAMEBUFFER: {
-				fb_tag = (struct multiboot_tag_framebuffer *)tag;
+static int mb2_handle_none(struct mb2_base_tag *tag) {
+	(void)tag;
+	return 0;
+}
 
-				// Set framebuffer
-				struct multiboot_tag_framebuffer_common common = (struct multiboot_tag_framebuffer_common)fb_tag->common;
-				set_term((void *)(common.framebuffer_addr), common.framebuffer_width, common.framebuffer_height, common.framebuffer_bpp);
-				ARC_DEBUG(INFO, "Framebuffer 0x%"PRIx64" (%d) %dx%dx%d\n", common.framebuffer_addr, common.framebuffer_type, common.framebuffer_width, common.framebuffer_height, common.framebuffer_bpp);
+static int mb2_handle_cmdline(struct mb2_base_tag *tag) {
+	struct multiboot_tag_string *info = (struct multiboot_tag_string *)tag;
 
-				break;
-			}
+	ARC_DEBUG(INFO, "Command line: %s\n", info->string);
 
-			case MULTIBOOT_TAG_TYPE_MODULE: {
-				struct multiboot_tag_module *info = (struct multiboot_tag_module *)tag;
+	if (cmdline_parse(info->string) != 0) {
+		ARC_DEBUG(WARN, "Some options were not understood\n");
+	}
 
-				uint32_t last_address = ALIGN(info->mod_end, PAGE_SIZE);
+	return 0;
+}
 
-				ARC_DEBUG(INFO, "Module:\n");
-				ARC_DEBUG(INFO, "\tStart: 0x%"PRIx32"\n", info->mod_start);
-				ARC_DEBUG(INFO, "\tEnd: 0x%"PRIx32" (0x%"PRIx32")\n", info->mod_end, last_address);
-				ARC_DEBUG(INFO, "\tCommand: %s\n", info->cmdline);
+static int mb2_handle_framebuffer(struct mb2_base_tag *tag) {
+	struct multiboot_tag_framebuffer *fb_tag = (struct multiboot_tag_framebuffer *)tag;
 
-				// Check if the last address (page aligned) is higher
-				// than the current end of the bootstrapper, so it can
-				// be excluded from the ARC_MMap
-				if (last_address > bootstrap_end_phys) {
-					bootstrap_end_phys = last_address;
-				}
+	if (!Arc_BootTunables.framebuffer) {
+		ARC_DEBUG(INFO, "Framebuffer disabled by command line\n");
+		return 0;
+	}
 
-				// Check for important modules (kernel + initramfs) and set
-				// proper variables
-				if (strcmp(info->cmdline, "arctan-module.kernel.elf") == 0) {
-					ARC_DEBUG(INFO, "\tFound kernel!\n");
-					Arc_KernelMeta.kernel_elf = (uint64_t)info->mod_start;
-				} else if (strcmp(info->cmdline, "arctan-module.initramfs.cpio") == 0) {
-					ARC_DEBUG(INFO, "\tFound initramfs!\n");
-					Arc_KernelMeta.initramfs.base = (uint64_t)info->mod_start;
-					Arc_KernelMeta.initramfs.size = (uint64_t)(info->mod_end - info->mod_start);
-				}
+	// Set framebuffer
+	struct multiboot_tag_framebuffer_common common = (struct multiboot_tag_framebuffer_common)fb_tag->common;
+	ARC_DEBUG(INFO, "Framebuffer 0x%"PRIx64" (%d) %dx%dx%d, pitch %d\n", common.framebuffer_addr, common.framebuffer_type, common.framebuffer_width, common.framebuffer_height, common.framebuffer_bpp, common.framebuffer_pitch);
 
-				break;
-			}
+	// EGA text and indexed modes cannot be drawn to
+	if (common.framebuffer_type != MULTIBOOT_FRAMEBUFFER_TYPE_RGB) {
+		ARC_DEBUG(WARN, "Framebuffer is not RGB, ignoring\n");
+		return 0;
+	}
 
-			case MULTIBOOT_TAG_TYPE_ELF_SECTIONS: {
-				// TODO: Could probably use this to get a more accurate bootstrap_end_phys
-				struct multiboot_tag_elf_sections *info = (struct multiboot_tag_elf_sections *)tag;
+	set_term(common.framebuffer_addr, common.framebuffer_width, common.framebuffer_height, common.framebuffer_pitch, common.framebuffer_bpp);
 
-				break;
-			}
+	return 0;
+}
 
-			case MULTIBOOT_TAG_TYPE_LOAD_BASE_ADDR: {
-				// The image is relocatable, check for the load base
-				// and calculate the last address used by bootstrap.elf
-				struct multiboot_tag_load_base_addr *info = (struct multiboot_tag_load_base_addr *)tag;
+static int mb2_handle_module(struct mb2_base_tag *tag) {
+	struct multiboot_tag_module *info = (struct multiboot_tag_module *)tag;
 
-				Arc_BootMeta.bsp_image.base = (uint64_t)info->load_base_addr;
-				Arc_BootMeta.bsp_image.size = ALIGN((uint64_t)((uintptr_t)&__BOOTSTRAP_END__ - (uintptr_t)&__BOOTSTRAP_START__), PAGE_SIZE);
+	uint32_t last_address = ALIGN(info->mod_end, PAGE_SIZE);
 
-				bootstrap_begin_phys = info->load_base_addr;
+	ARC_DEBUG(INFO, "Module:\n");
+	ARC_DEBUG(INFO, "\tStart: 0x%"PRIx32"\n", info->mod_start);
+	ARC_DEBUG(INFO, "\tEnd: 0x%"PRIx32" (0x%"PRIx32")\n", info->mod_end, last_address);
+	ARC_DEBUG(INFO, "\tCommand: %s\n", info->cmdline);
 
-				ARC_DEBUG(INFO, "Base address:\n");
-				ARC_DEBUG(INFO, "\tLoaded at: 0x%"PRIx32"\n", info->load_base_addr);
-				ARC_DEBUG(INFO, "\tSize: 0x%"PRIx64"\n", Arc_BootMeta.bsp_image.size);
+	// Only the module itself is excluded from the ARC_MMap, gaps
+	// between modules stay available
+	if (mb2_reserve(info->mod_start, last_address, ARC_MEMORY_BOOTSTRAP) != 0) {
+		return -1;
+	}
 
-				break;
-			}
+	// Place the module into the module table, this also picks
+	// out the kernel and initramfs
+	switch (module_register(info)) {
+		case ARC_BOOT_MODULE_KERNEL: {
+			ARC_DEBUG(INFO, "\tFound kernel!\n");
+			break;
+		}
 
-			case MULTIBOOT_TAG_TYPE_END: {
-				ARC_DEBUG(INFO, "Parsed primary tags\n");
+		case ARC_BOOT_MODULE_INITRAMFS: {
+			ARC_DEBUG(INFO, "\tFound initramfs!\n");
+			break;
+		}
 
-				break;
+		case ARC_BOOT_MODULE_DRIVER: {
+			ARC_DEBUG(INFO, "\tFound driver\n");
+			break;
+		}
+
+		case -1: {
+			// Losing the kernel would only show up much later as
+			// a missing kernel module
+			if (strcmp(info->cmdline, ARC_BSP_MODULE_KERNEL_NAME) == 0) {
+				ARC_DEBUG(ERR, "Kernel module %s could not be recorded\n", info->cmdline);
+				return -1;
 			}
+
+			break;
 		}
+	}
 
-		offset += ALIGN(tag->size, 8);
+	return 0;
+}
+
+static int mb2_handle_load_base(struct mb2_base_tag *tag) {
+	// The image is relocatable, check for the load base
+	// and calculate the last address used by bootstrap.elf
+	struct multiboot_tag_load_base_addr *info = (struct multiboot_tag_load_base_addr *)tag;
+
+	Arc_BootMeta.bsp_image.base = (uint64_t)info->load_base_addr;
+	Arc_BootMeta.bsp_image.size = ALIGN((uint64_t)((uintptr_t)&__BOOTSTRAP_END__ - (uintptr_t)&__BOOTSTRAP_START__), PAGE_SIZE);
+
+	ARC_DEBUG(INFO, "Base address:\n");
+	ARC_DEBUG(INFO, "\tLoaded at: 0x%"PRIx32"\n", info->load_base_addr);
+	ARC_DEBUG(INFO, "\tSize: 0x%"PRIx64"\n", Arc_BootMeta.bsp_image.size);
+
+	return 0;
+}
+
+static int mb2_handle_loader_name(struct mb2_base_tag *tag) {
+	// Cosmetic
+	struct multiboot_tag_string *info = (struct multiboot_tag_string *)tag;
+
+	ARC_DEBUG(INFO, "Bootloader: %s\n", info->string);
+
+	return 0;
+}
+
+static int mb2_handle_efi32(struct mb2_base_tag *tag) {
+	(void)tag;
+	ARC_DEBUG(WARN, "EFI32\n");
+	return 0;
+}
+
+static int mb2_handle_efi64(struct mb2_base_tag *tag) {
+	(void)tag;
+	ARC_DEBUG(WARN, "EFI64\n");
+	return 0;
+}
+
+static int mb2_handle_efi_bs(struct mb2_base_tag *tag) {
+	(void)tag;
+	ARC_DEBUG(ERR, "EFI bootservices not terminated\n");
+
+	// TODO: Terminate them, until then their memory is kept
+	//       reserved when building the ARC_MMap
+
+	return 0;
+}
+
+static int mb2_handle_meminfo(struct mb2_base_tag *tag) {
+	struct multiboot_tag_basic_meminfo *info = (struct multiboot_tag_basic_meminfo *)tag;
+
+	ARC_DEBUG(INFO, "Basic memory:\n");
+	ARC_DEBUG(INFO, "\tLow: %d KiB\n", info->mem_lower);
+	ARC_DEBUG(INFO, "\tHigh: %d KiB\n", info->mem_upper);
+
+	return 0;
+}
+
+static int mb2_handle_acpi_new(struct mb2_base_tag *tag) {
+	struct multiboot_tag_new_acpi *acpi = (struct multiboot_tag_new_acpi *)tag;
+	Arc_KernelMeta.rsdp = (uintptr_t)&acpi->rsdp;
+	ARC_DEBUG(INFO, "Found new ACPI (0x%"PRIx64")\n", acpi->rsdp);
+
+	return 0;
+}
+
+static int mb2_handle_acpi_old(struct mb2_base_tag *tag) {
+	struct multiboot_tag_old_acpi *acpi = (struct multiboot_tag_old_acpi *)tag;
+
+	// Prefer the new RSDP if GRUB gave both
+	if (Arc_KernelMeta.rsdp == 0) {
+		Arc_KernelMeta.rsdp = (uintptr_t)&acpi->rsdp;
 	}
 
-	// After parsing primary information, parse
-	// secondary information
-	offset = 8;
+	ARC_DEBUG(INFO, "Found old ACPI (0x%"PRIx32")\n", acpi->rsdp);
 
-	// Go through the rest of the tags and initialize the meta
-	//    If a memory map is found, parse it into a ARC_MMap
-	while (offset < total_size) {
-		struct mb2_base_tag *tag = (struct mb2_base_tag *)(mb2i + offset);
+	return 0;
+}
 
-		switch (tag->type) {
-			case MULTIBOOT_TAG_TYPE_BOOT_LOADER_NAME: {
-				// Cosmetic
-				struct multiboot_tag_string *info = (struct multiboot_tag_string *)tag;
+static int mb2_handle_apm(struct mb2_base_tag *tag) {
+	(void)tag;
+	ARC_DEBUG(WARN, "Found APM (implement)\n");
+	return 0;
+}
 
-				ARC_DEBUG(INFO, "Bootloader: %s\n", info->string);
+static int mb2_handle_bootdev(struct mb2_base_tag *tag) {
+	(void)tag;
+	ARC_DEBUG(WARN, "Found bootdev (implement)\n");
+	return 0;
+}
 
-				break;
-			}
+static int mb2_handle_vbe(struct mb2_base_tag *tag) {
+	(void)tag;
+	ARC_DEBUG(WARN, "Found VBE (implement)\n");
+	return 0;
+}
 
-			case MULTIBOOT_TAG_TYPE_MMAP: {
-				// BIOS memory map, grab it print it, and reconstruct it into
-				// the ARC_MMap
-				struct multiboot_tag_mmap *info = (struct multiboot_tag_mmap *)tag;
-				uint32_t entries = (info->size - sizeof(struct multiboot_tag_mmap)) / info->entry_size;
+static int mb2_handle_efi_mmap(struct mb2_base_tag *tag) {
+	struct multiboot_tag_efi_mmap *info = (struct multiboot_tag_efi_mmap *)tag;
 
-				ARC_DEBUG(INFO, "Found MMap (%d, %d entries)\n", info->entry_version, entries);
+	ARC_DEBUG(INFO, "Found EFI MMap (%d, %d byte descriptors)\n", info->descr_vers, info->descr_size);
 
-				// Sort entries by ascending base address and place them into the list
-				for (uint32_t i = 0, j = 0; i < entries; i++) {
-					struct multiboot_mmap_entry entry = info->entries[i];
+	return 0;
+}
 
-					uint32_t idx = j;
+static int mb2_handle_elf_sections(struct mb2_base_tag *tag) {
+	struct multiboot_tag_elf_sections *info = (struct multiboot_tag_elf_sections *)tag;
 
-					for (uint32_t _j = 0; _j < j; _j++) {
-						if (entry.addr <= arc_mmap[_j].base) {
-							idx = _j;
-							nmemcpy(&arc_mmap[_j + 1], &arc_mmap[_j], (j - _j) * sizeof(struct ARC_MMap));
-							break;
-						}
-					}
+	if (info->entsize < sizeof(struct elf32_shdr)) {
+		ARC_DEBUG(WARN, "ELF section headers too small (%d)\n", info->entsize);
+		return 0;
+	}
 
-					arc_mmap[idx].base = entry.addr;
-					arc_mmap[idx].len = entry.len;
-					arc_mmap[idx].type = mb2_MMType2Type(entry.type);
-					j++;
-				}
+	uint64_t lo = UINT64_MAX;
+	uint64_t hi = 0;
 
-				for (uint32_t i = 0; i < entries - 1; i++) {
-					uint64_t ceil = arc_mmap[i].base + arc_mmap[i].len;
-
-					if (arc_mmap[i + 1].base < ceil) {
-						size_t delta = min(ceil - arc_mmap[i + 1].base, arc_mmap[i + 1].len);
-
-						if (arc_mmap[i].type == arc_mmap[i + 1].type) {
-							// Merge
-							arc_mmap[i].len += arc_mmap[i + 1].len;
-
-							if (i != entries - 2) {
-								memcpy(&arc_mmap[i + 1], &arc_mmap[i + 2], (entries - i - 2) * sizeof(struct ARC_MMap));
-							} else {
-								memset(&arc_mmap[i + 1], 0, sizeof(struct ARC_MMap));
-							}
-
-							entries--;
-						}
-
-						if (arc_mmap[i].type < arc_mmap[i + 1].type) {
-							// [i] takes precendence over [i + 1]
-							arc_mmap[i + 1].base += delta;
-							arc_mmap[i + 1].len -= delta;
-
-							if (arc_mmap[i + 1].len == 0) {
-								if (i != entries - 2) {
-									memcpy(&arc_mmap[i + 1], &arc_mmap[i + 2], (entries - i - 2) * sizeof(struct ARC_MMap));
-								} else {
-									memset(&arc_mmap[i + 1], 0, sizeof(struct ARC_MMap));
-								}
-
-								entries--;
-							}
-						} else {
-							// [i + 1] takes precendence over [i]
-							arc_mmap[i].len -= delta;
-						}
-					}
-
-					if (arc_mmap[i].base >= bootstrap_begin_phys && arc_mmap[i].base < bootstrap_end_phys) {
-						size_t delta = bootstrap_end_phys - arc_mmap[i].base;
-						if (delta >= arc_mmap[i].len && arc_mmap[i].type > ARC_MEMORY_BOOTSTRAP) {
-							// Reserve
-							arc_mmap[i].type = ARC_MEMORY_BOOTSTRAP;
-						} else if (delta < arc_mmap[i].len) {
-							// Split
-							nmemcpy(&arc_mmap[i + 1], &arc_mmap[i], (entries - i) * sizeof(struct ARC_MMap));
-							arc_mmap[i + 1].len -= delta;
-							arc_mmap[i + 1].base += delta;
-							arc_mmap[i].len = delta;
-							arc_mmap[i].type = ARC_MEMORY_BOOTSTRAP;
-
-							entries++;
-						}
-					}
+	for (uint32_t i = 0; i < info->num; i++) {
+		struct elf32_shdr *shdr = (struct elf32_shdr *)(info->sections + i * info->entsize);
 
-				}
-			
-				Arc_KernelMeta.arc_mmap.base = (uintptr_t)&arc_mmap;
-				Arc_KernelMeta.arc_mmap.len = entries;
-				Arc_BootMeta.mem_size = arc_mmap[entries - 1].base + arc_mmap[entries - 1].len;
+		if (shdr->sh_addr == 0 || shdr->sh_size == 0) {
+			continue;
+		}
 
-				const char *names[] = {
-                                        [ARC_MEMORY_AVAILABLE] = "Available",
-                                        [ARC_MEMORY_ACPI_RECLAIMABLE] = "ACPI Reclaimable",
-                                        [ARC_MEMORY_BADRAM] = "Bad",
-                                        [ARC_MEMORY_NVS] = "NVS",
-                                        [ARC_MEMORY_RESERVED] = "Reserved",
-				        [ARC_MEMORY_BOOTSTRAP] = "Bootstrap"
-			        };
-
-				ARC_DEBUG(INFO, "Memory size: 0x%"PRIx64"\n", Arc_BootMeta.mem_size);
-				ARC_DEBUG(INFO, "Arctan MMap: 0x%"PRIx64" (%d entries)\n", Arc_KernelMeta.arc_mmap.base, Arc_KernelMeta.arc_mmap.len);
-				for (uint32_t i = 0; i < Arc_KernelMeta.arc_mmap.len; i++) {
-					struct ARC_MMap entry = arc_mmap[i];
-					ARC_DEBUG(INFO, "\t%3d : 0x%016"PRIx64" -> 0x%016"PRIx64" (0x%016"PRIx64" bytes) | %s (%d)\n", i, entry.base, entry.base + entry.len, entry.len, names[entry.type], entry.type);
-				}
+		if (shdr->sh_flags & ELF32_SHF_ALLOC) {
+			lo = min(lo, (uint64_t)shdr->sh_addr);
+			hi = max(hi, (uint64_t)shdr->sh_addr + shdr->sh_size);
+			continue;
+		}
 
-				break;
-			}
+		// Sections which are not part of the image (i.e. the symbol
+		// table) were placed by GRUB and are referenced by this tag
+		if (mb2_reserve(shdr->sh_addr, (uint64_t)shdr->sh_addr + shdr->sh_size, ARC_MEMORY_BOOTSTRAP) != 0) {
+			return -1;
+		}
+	}
 
-			case MULTIBOOT_TAG_TYPE_EFI_MMAP: {
-				ARC_DEBUG(WARN, "Found EFI MMap (implement)\n");
-				// TODO: Implement EFI mmap parsing
+	if (hi > lo) {
+		image_span = hi - lo;
+	}
 
+	ARC_DEBUG(INFO, "ELF sections: %d, image spans 0x%"PRIx64" B\n", info->num, image_span);
 
+	return 0;
+}
 
-				break;
-			}
+// Handlers called for each tag as it is walked, tags which depend on
+// others (i.e. the MMap, or the framebuffer on the command line) are
+// handled afterwards using the tag directory
+static int (*const tag_handlers[MB2_TAG_TYPE_COUNT])(struct mb2_base_tag *tag) = {
+	[MULTIBOOT_TAG_TYPE_END] = mb2_handle_none,
+	[MULTIBOOT_TAG_TYPE_CMDLINE] = mb2_handle_cmdline,
+	[MULTIBOOT_TAG_TYPE_BOOT_LOADER_NAME] = mb2_handle_loader_name,
+	[MULTIBOOT_TAG_TYPE_MODULE] = mb2_handle_module,
+	[MULTIBOOT_TAG_TYPE_BASIC_MEMINFO] = mb2_handle_meminfo,
+	[MULTIBOOT_TAG_TYPE_BOOTDEV] = mb2_handle_bootdev,
+	[MULTIBOOT_TAG_TYPE_MMAP] = mb2_handle_none,
+	[MULTIBOOT_TAG_TYPE_VBE] = mb2_handle_vbe,
+	[MULTIBOOT_TAG_TYPE_FRAMEBUFFER] = mb2_handle_none,
+	[MULTIBOOT_TAG_TYPE_ELF_SECTIONS] = mb2_handle_elf_sections,
+	[MULTIBOOT_TAG_TYPE_APM] = mb2_handle_apm,
+	[MULTIBOOT_TAG_TYPE_EFI32] = mb2_handle_efi32,
+	[MULTIBOOT_TAG_TYPE_EFI64] = mb2_handle_efi64,
+	[MULTIBOOT_TAG_TYPE_ACPI_OLD] = mb2_handle_acpi_old,
+	[MULTIBOOT_TAG_TYPE_ACPI_NEW] = mb2_handle_acpi_new,
+	[MULTIBOOT_TAG_TYPE_EFI_MMAP] = mb2_handle_efi_mmap,
+	[MULTIBOOT_TAG_TYPE_EFI_BS] = mb2_handle_efi_bs,
+	[MULTIBOOT_TAG_TYPE_LOAD_BASE_ADDR] = mb2_handle_load_base,
+};
 
-			case MULTIBOOT_TAG_TYPE_EFI32: {
-				ARC_DEBUG(WARN, "EFI32\n");
+/**
+ * Select the firmware memory map to build the ARC_MMap from.
+ *
+ * Prefers the EFI memory map when GRUB provides one, as the legacy map
+ * it derives from it folds boot services memory into reserved ranges.
+ *
+ * @return Error code (0: success).
+ * */
+static int mb2_mmap_select(struct mb2_mmap_source *src) {
+	struct multiboot_tag_efi_mmap *efi = mb2_get_tag(MULTIBOOT_TAG_TYPE_EFI_MMAP);
+	struct multiboot_tag_mmap *bios = mb2_get_tag(MULTIBOOT_TAG_TYPE_MMAP);
 
-				break;
-			}
+	memset(src, 0, sizeof(*src));
 
-			case MULTIBOOT_TAG_TYPE_EFI64: {
-				ARC_DEBUG(WARN, "EFI64\n");
+	if (efi != NULL && efi->descr_size >= sizeof(struct efi_memory_descriptor)) {
+		src->efi = efi;
+		src->count = (efi->size - sizeof(struct multiboot_tag_efi_mmap)) / efi->descr_size;
+		src->bs_active = mb2_get_tag(MULTIBOOT_TAG_TYPE_EFI_BS) != NULL;
 
-				break;
-			}
+		ARC_DEBUG(INFO, "Using EFI MMap (%d entries)\n", src->count);
+	} else if (bios != NULL && bios->entry_size != 0) {
+		src->bios = bios;
+		src->count = (bios->size - sizeof(struct multiboot_tag_mmap)) / bios->entry_size;
 
-			case MULTIBOOT_TAG_TYPE_EFI_BS: {
-				ARC_DEBUG(ERR, "EFI bootservices not terminated\n");
+		ARC_DEBUG(INFO, "Using MMap (%d, %d entries)\n", bios->entry_version, src->count);
+	}
 
-				// TODO: Terminate them
+	return src->count == 0 ? -1 : 0;
+}
 
-				break;
-			}
+/**
+ * Read a firmware memory map entry as an ARC_MMap entry.
+ * */
+static void mb2_mmap_read(struct mb2_mmap_source *src, uint32_t i, struct ARC_MMap *out) {
+	if (src->bios != NULL) {
+		struct multiboot_mmap_entry *entry = (struct multiboot_mmap_entry *)((uintptr_t)src->bios->entries + i * src->bios->entry_size);
 
-			case MULTIBOOT_TAG_TYPE_BASIC_MEMINFO: {
-				struct multiboot_tag_basic_meminfo *info = (struct multiboot_tag_basic_meminfo *)tag;
+		out->base = entry->addr;
+		out->len = entry->len;
+		out->type = mb2_MMType2Type(entry->type);
 
-				ARC_DEBUG(INFO, "Basic memory:\n");
-				ARC_DEBUG(INFO, "\tLow: %d KiB\n", info->mem_lower);
-				ARC_DEBUG(INFO, "\tHigh: %d KiB\n", info->mem_upper);
+		return;
+	}
 
-				break;
-			}
+	// Descriptors may be larger than the structure, always step by descr_size
+	struct efi_memory_descriptor *desc = (struct efi_memory_descriptor *)(src->efi->efi_mmap + i * src->efi->descr_size);
 
-			case MULTIBOOT_TAG_TYPE_ACPI_NEW: {
-				struct multiboot_tag_new_acpi *acpi = (struct multiboot_tag_new_acpi *)tag;
-				Arc_KernelMeta.rsdp = (uintptr_t)&acpi->rsdp;
-				ARC_DEBUG(INFO, "Found new ACPI (0x%"PRIx64")\n", acpi->rsdp);
+	out->base = desc->physical_start;
+	out->len = desc->pages * EFI_PAGE_SIZE;
+	out->type = mb2_EFIType2Type(desc->type, src->bs_active);
 
-				break;
-			}
+	if ((desc->attribute & EFI_MEMORY_RUNTIME) != 0) {
+		// Runtime regions must never be handed out, whatever their type
+		out->type = min(out->type, (uint32_t)ARC_MEMORY_RESERVED);
+	}
+}
 
-			case MULTIBOOT_TAG_TYPE_ACPI_OLD: {
-				struct multiboot_tag_old_acpi *acpi = (struct multiboot_tag_old_acpi *)tag;
-				Arc_KernelMeta.rsdp = (uintptr_t)&acpi->rsdp;
-				ARC_DEBUG(INFO, "Found old ACPI (0x%"PRIx32")\n", acpi->rsdp);
+/**
+ * Record the EFI regions with the runtime attribute in efi_runtime.
+ * */
+static void mb2_read_efi_runtime(struct mb2_mmap_source *src) {
+	uint32_t runtime = 0;
 
-				break;
-			}
+	for (uint32_t i = 0; i < src->count; i++) {
+		struct efi_memory_descriptor *desc = (struct efi_memory_descriptor *)(src->efi->efi_mmap + i * src->efi->descr_size);
 
-			case MULTIBOOT_TAG_TYPE_APM: {
-				ARC_DEBUG(WARN, "Found APM (implement)\n");
+		if ((desc->attribute & EFI_MEMORY_RUNTIME) == 0) {
+			continue;
+		}
 
-				break;
-			}
+		if (runtime >= ARC_EFI_MAX_RUNTIME) {
+			ARC_DEBUG(WARN, "Too many EFI runtime regions, dropping 0x%"PRIx64"\n", desc->physical_start);
+			continue;
+		}
+
+		efi_runtime[runtime].phys = desc->physical_start;
+		efi_runtime[runtime].virt = desc->virtual_start;
+		efi_runtime[runtime].pages = desc->pages;
+		efi_runtime[runtime].attributes = desc->attribute;
+		efi_runtime[runtime].type = desc->type;
+		runtime++;
+	}
 
-			case MULTIBOOT_TAG_TYPE_BOOTDEV: {
-				ARC_DEBUG(WARN, "Found bootdev (implement)\n");
+	Arc_KernelMeta.efi_runtime.base = (uintptr_t)&efi_runtime;
+	Arc_KernelMeta.efi_runtime.len = runtime;
 
-				break;
-			}
+	ARC_DEBUG(INFO, "%d EFI runtime regions\n", runtime);
+}
+
+// Reservations the ARC_MMap's storage must not overlap, sorted by base
+static struct ARC_MMap storage_blockers[MB2_MAX_RESERVATIONS] = { 0 };
+static int storage_blocker_count = 0;
 
-			case MULTIBOOT_TAG_TYPE_VBE: {
-				ARC_DEBUG(WARN, "Found VBE (implement)\n");
+/**
+ * Move pos past every sorted reservation overlapping size bytes at pos.
+ * */
+static uint64_t mb2_storage_skip_blockers(uint64_t pos, size_t size) {
+	for (int i = 0; i < storage_blocker_count; i++) {
+		struct ARC_MMap *blocker = &storage_blockers[i];
+
+		if (blocker->base >= pos + size) {
+			break;
+		}
 
-				break;
+		if (blocker->base + blocker->len > pos) {
+			pos = ALIGN(blocker->base + blocker->len, (uint64_t)PAGE_SIZE);
+		}
+	}
+
+	return pos;
+}
+
+/**
+ * Find memory for the ARC_MMap before it exists.
+ *
+ * Searches the firmware's available ranges below 4 GiB for size bytes
+ * which overlap neither another firmware range nor any of the given
+ * reservations.
+ *
+ * @return Physical address of the memory, 0 if none was found.
+ * */
+static uint64_t mb2_mmap_find_storage(struct mb2_mmap_source *src, size_t size, struct ARC_MMap *avoid, int avoid_count) {
+	// Sort the reservations so each candidate is checked against them
+	// in one short sweep
+	storage_blocker_count = 0;
+
+	for (int i = 0; i < avoid_count && i < MB2_MAX_RESERVATIONS; i++) {
+		int j = storage_blocker_count++;
+
+		for (; j > 0 && storage_blockers[j - 1].base > avoid[i].base; j--) {
+			storage_blockers[j] = storage_blockers[j - 1];
+		}
+
+		storage_blockers[j] = avoid[i];
+	}
+
+	for (uint32_t i = 0; i < src->count; i++) {
+		struct ARC_MMap region = { 0 };
+		mb2_mmap_read(src, i, &region);
+
+		if (region.type != ARC_MEMORY_AVAILABLE) {
+			continue;
+		}
+
+		uint64_t region_end = min(region.base + region.len, (uint64_t)UINT32_MAX + 1);
+		uint64_t pos = ALIGN(max(region.base, (uint64_t)0x100000), (uint64_t)PAGE_SIZE);
+
+		// Firmware ranges only overlap each other in malformed maps, so
+		// the firmware map is only walked for positions clear of every
+		// reservation, and every range it hits is skipped at once
+		while ((pos = mb2_storage_skip_blockers(pos, size)) + size <= region_end) {
+			uint64_t conflict = 0;
+
+			for (uint32_t j = 0; j < src->count; j++) {
+				struct ARC_MMap other = { 0 };
+				mb2_mmap_read(src, j, &other);
+
+				if (other.type != ARC_MEMORY_AVAILABLE && other.base < pos + size && other.base + other.len > pos) {
+					conflict = max(conflict, other.base + other.len);
+				}
+			}
+
+			if (conflict == 0) {
+				return pos;
 			}
 
-				// Already handled
-			case MULTIBOOT_TAG_TYPE_ELF_SECTIONS: { break; }
-			case MULTIBOOT_TAG_TYPE_MODULE: { break; }
-			case MULTIBOOT_TAG_TYPE_LOAD_BASE_ADDR: { break; }
-			case MULTIBOOT_TAG_TYPE_CMDLINE: { break; }
-			case MULTIBOOT_TAG_TYPE_FRAMEBUFFER: { break; }
+			pos = ALIGN(conflict, (uint64_t)PAGE_SIZE);
+		}
+	}
 
-			case MULTIBOOT_TAG_TYPE_END: {
-				ARC_DEBUG(INFO, "Parsed secondary tags\n");
+	return 0;
+}
 
-				break;
+/**
+ * Reconstruct the firmware memory map into the ARC_MMap.
+ *
+ * Needs the extent of the bootstrapper and modules, so it is run once
+ * all tags have been walked.
+ * */
+static int mb2_parse_mmap(uint8_t *mb2i) {
+	struct mb2_mmap_source src = { 0 };
+
+	if (mb2_mmap_select(&src) != 0) {
+		ARC_DEBUG(ERR, "No memory map given\n");
+		return -1;
+	}
+
+	if (src.efi != NULL) {
+		mb2_read_efi_runtime(&src);
+	}
+
+	// The tags are passed on to the kernel
+	if (mb2_reserve((uintptr_t)mb2i, (uintptr_t)mb2i + *(uint32_t *)mb2i, ARC_MEMORY_BOOTSTRAP) != 0) {
+		return -1;
+	}
+
+	// Size the map from the firmware's entry count, leaving room for the
+	// reservation of its own storage. The scratch memory used to
+	// normalise it follows the map and is not kept
+	int overlay_count = reservation_count + 1;
+	int capacity = mmap_capacity(src.count, overlay_count);
+	size_t map_size = ALIGN(capacity * sizeof(struct ARC_MMap), PAGE_SIZE);
+	size_t scratch_size = mmap_scratch_size(src.count, overlay_count);
+	uint64_t storage = mb2_mmap_find_storage(&src, map_size + scratch_size, reservations, reservation_count);
+
+	if (storage == 0 || mb2_reserve(storage, storage + map_size, ARC_MEMORY_BOOTSTRAP_ALLOC) != 0) {
+		ARC_DEBUG(ERR, "No memory for a %d entry MMap\n", capacity);
+		return -1;
+	}
+
+	struct ARC_MMap *arc_mmap = (struct ARC_MMap *)(uintptr_t)storage;
+
+#if defined(ARC_TARGET_ARCH_X86_64) || defined(ARC_TARGET_ARCH_X86)
+	uint64_t start_tsc = _x86_RDTSC();
+#endif
+
+	for (uint32_t i = 0; i < src.count; i++) {
+		mb2_mmap_read(&src, i, &arc_mmap[i]);
+	}
+
+	int count = mmap_normalize(arc_mmap, src.count, capacity, reservations, reservation_count, (void *)(uintptr_t)(storage + map_size));
+
+	if (count <= 0) {
+		ARC_DEBUG(ERR, "Failed to normalise MMap\n");
+		return -1;
+	}
+
+#if defined(ARC_TARGET_ARCH_X86_64) || defined(ARC_TARGET_ARCH_X86)
+	uint64_t cycles = _x86_RDTSC() - start_tsc;
+	ARC_DEBUG(INFO, "Normalised %d entries into %d in %"PRIu64" cycles (%"PRIu64" per entry)\n", src.count, count, cycles, cycles / src.count);
+#endif
+
+#ifdef ARC_DEBUG_ENABLE
+	if (mmap_check(arc_mmap, count, reservations, reservation_count) != 0) {
+		ARC_DEBUG(ERR, "Normalised MMap is inconsistent\n");
+		return -1;
+	}
+#endif
+
+	mmap_use(arc_mmap, count, capacity);
+	Arc_BootMeta.mem_size = arc_mmap[count - 1].base + arc_mmap[count - 1].len;
+
+	const char *names[] = {
+                                        [ARC_MEMORY_AVAILABLE] = "Available",
+                                        [ARC_MEMORY_ACPI_RECLAIMABLE] = "ACPI Reclaimable",
+                                        [ARC_MEMORY_BADRAM] = "Bad",
+                                        [ARC_MEMORY_NVS] = "NVS",
+                                        [ARC_MEMORY_RESERVED] = "Reserved",
+	        [ARC_MEMORY_BOOTSTRAP] = "Bootstrap",
+	        [ARC_MEMORY_BOOTSTRAP_ALLOC] = "Bootstrap Allocated"
+        };
+
+	ARC_DEBUG(INFO, "Memory size: 0x%"PRIx64"\n", Arc_BootMeta.mem_size);
+	ARC_DEBUG(INFO, "Arctan MMap: 0x%"PRIx64" (%d entries)\n", Arc_KernelMeta.arc_mmap.base, Arc_KernelMeta.arc_mmap.len);
+	for (uint32_t i = 0; i < Arc_KernelMeta.arc_mmap.len; i++) {
+		struct ARC_MMap entry = arc_mmap[i];
+		ARC_DEBUG(INFO, "\t%3d : 0x%016"PRIx64" -> 0x%016"PRIx64" (0x%016"PRIx64" bytes) | %s (%d)\n", i, entry.base, entry.base + entry.len, entry.len, names[entry.type], entry.type);
+	}
+
+	return 0;
+}
+
+int parse_mb2i(uint8_t *mb2i) {
+	// Get information from the fixed tag
+	uint32_t total_size = *(uint32_t *)mb2i;
+
+	if (total_size == 0) {
+		ARC_DEBUG(ERR, "Given MB2I's size is 0\n");
+		return -1;
+	}
+
+	Arc_KernelMeta.boot.proc = ARC_BOOTPROC_MB2;
+	Arc_KernelMeta.boot.info.grub_tags = (uint64_t)mb2i;
+	// The kernel gets the tunables even if there is no command line
+	Arc_KernelMeta.tunables = (uintptr_t)&Arc_BootTunables;
+
+	ARC_DEBUG(INFO, "Parsing Multiboot2 tags\n");
+
+	// Walk the tags once, handling each and recording the first
+	// tag of each type in the directory
+	for (uint32_t offset = 8; offset + sizeof(struct mb2_base_tag) <= total_size;) {
+		struct mb2_base_tag *tag = (struct mb2_base_tag *)(mb2i + offset);
+
+		if (tag->type == MULTIBOOT_TAG_TYPE_END) {
+			break;
+		}
+
+		// A tag smaller than its header would never advance the walk
+		if (tag->size < sizeof(struct mb2_base_tag) || tag->size > total_size - offset) {
+			ARC_DEBUG(ERR, "Tag (%d) at %p (:%d) has bad size %d\n", tag->type, tag, offset, tag->size);
+			return -1;
+		}
+
+		if (tag->type >= MB2_TAG_TYPE_COUNT || tag_handlers[tag->type] == NULL) {
+			ARC_DEBUG(ERR, "Unhandled tag (%d) at %p (:%d)\n", tag->type, tag, offset);
+		} else {
+			if (tag_directory[tag->type] == NULL) {
+				tag_directory[tag->type] = tag;
 			}
-			default: {
-				ARC_DEBUG(ERR, "Unhandled tag (%d) at %p (:%d)\n", tag->type, tag, offset);
 
-				break;
+			if (tag_handlers[tag->type](tag) != 0) {
+				ARC_DEBUG(ERR, "Failed to handle tag (%d)\n", tag->type);
+				return -1;
 			}
 		}
 
 		offset += ALIGN(tag->size, 8);
 	}
 
+	ARC_DEBUG(INFO, "Parsed tags\n");
+
+	// Without a load base the image was loaded where it was linked
+	if (Arc_BootMeta.bsp_image.base == 0) {
+		Arc_BootMeta.bsp_image.base = (uintptr_t)&__BOOTSTRAP_START__;
+		Arc_BootMeta.bsp_image.size = ALIGN((uint64_t)((uintptr_t)&__BOOTSTRAP_END__ - (uintptr_t)&__BOOTSTRAP_START__), PAGE_SIZE);
+	}
+
+	// The linker symbols cover everything that is loaded, the sections
+	// may also cover anything placed past them
+	Arc_BootMeta.bsp_image.size = max(Arc_BootMeta.bsp_image.size, ALIGN(image_span, (uint64_t)PAGE_SIZE));
+
+	if (mb2_reserve(Arc_BootMeta.bsp_image.base, Arc_BootMeta.bsp_image.base + Arc_BootMeta.bsp_image.size, ARC_MEMORY_BOOTSTRAP) != 0) {
+		return -1;
+	}
+
+	if (mb2_parse_mmap(mb2i) != 0) {
+		return -1;
+	}
+
+	// GRUB may place the framebuffer tag before the command line, which
+	// decides whether and how it is used. The terminal allocates its text
+	// shadow, so this also has to wait for the MMap
+	struct mb2_base_tag *framebuffer = mb2_get_tag(MULTIBOOT_TAG_TYPE_FRAMEBUFFER);
+
+	if (framebuffer != NULL && mb2_handle_framebuffer(framebuffer) != 0) {
+		return -1;
+	}
+
 	return 0;
 }
@@ -0,0 +1,226 @@
+/**
+ * @file module.c
+ *
+ * @author awewsomegamer <awewsomegamer@gmail.com>
+ *
+ * @LICENSE
+ * Arctan-OS/BSP-GRUB - GRUB bootstrapper for Arctan-OS/Kernel
+ * Copyright (C) 2023-2025 awewsomegamer
+ *
+ * This file is part of Arctan-OS/BSP-GRUB
+ *
+ * Arctan is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 2
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ * @DESCRIPTION
+ * Keeps a table of all modules given by GRUB for the kernel and links
+ * driver modules against the kernel so they are ready to be initialized.
+*/
+#define ARC_DEBUG_SUBSYS ARC_DEBUG_SUBSYS_BOOT
+
+#include <boot/module.h>
+#include <global.h>
+#include <elf.h>
+#include <crc32c.h>
+#include <inttypes.h>
+
+static struct ARC_BootModule modules[ARC_BSP_MAX_MODULES] = { 0 };
+static uint32_t module_count = 0;
+
+int module_register(struct multiboot_tag_module *tag) {
+	if (module_count >= ARC_BSP_MAX_MODULES) {
+		ARC_DEBUG(ERR, "Module table full (%d entries), dropping module %s\n", ARC_BSP_MAX_MODULES, tag->cmdline);
+		return -1;
+	}
+
+	struct ARC_BootModule *module = &modules[module_count++];
+
+	module->name = (uintptr_t)tag->cmdline;
+	module->base = tag->mod_start;
+	module->size = tag->mod_end - tag->mod_start;
+	module->type = ARC_BOOT_MODULE_OTHER;
+
+	if (strcmp(tag->cmdline, ARC_BSP_MODULE_KERNEL_NAME) == 0) {
+		module->type = ARC_BOOT_MODULE_KERNEL;
+		Arc_KernelMeta.kernel_elf = module->base;
+	} else if (strcmp(tag->cmdline, ARC_BSP_MODULE_INITRAMFS_NAME) == 0) {
+		module->type = ARC_BOOT_MODULE_INITRAMFS;
+		Arc_KernelMeta.initramfs.base = module->base;
+		Arc_KernelMeta.initramfs.size = module->size;
+	} else if (strncmp(tag->cmdline, ARC_BSP_MODULE_DRIVER_PREFIX, sizeof(ARC_BSP_MODULE_DRIVER_PREFIX) - 1) == 0) {
+		module->type = ARC_BOOT_MODULE_DRIVER;
+	}
+
+	Arc_KernelMeta.modules.base = (uintptr_t)&modules;
+	Arc_KernelMeta.modules.len = module_count;
+
+	return module->type;
+}
+
+static struct ARC_BootModule *module_find(char *name, size_t len) {
+	for (uint32_t i = 0; i < module_count; i++) {
+		char *module_name = (char *)(uintptr_t)modules[i].name;
+
+		if (strncmp(module_name, name, len) == 0 && module_name[len] == 0) {
+			return &modules[i];
+		}
+	}
+
+	return NULL;
+}
+
+static int is_space(char c) {
+	return c == ' ' || c == '\t' || c == '\r';
+}
+
+int module_verify() {
+	struct ARC_BootModule *manifest = module_find(ARC_BSP_MODULE_MANIFEST_NAME, sizeof(ARC_BSP_MODULE_MANIFEST_NAME) - 1);
+
+	if (manifest == NULL) {
+		return 0;
+	}
+
+	ARC_DEBUG(INFO, "Verifying modules against manifest\n");
+
+	init_crc32c();
+
+	char *line = (char *)(uintptr_t)manifest->base;
+	char *end = line + manifest->size;
+	int r = 0;
+
+	while (line < end) {
+		char *next = line;
+		while (next < end && *next != '\n') {
+			next++;
+		}
+
+		char *c = line;
+		while (c < next && is_space(*c)) {
+			c++;
+		}
+
+		if (c == next || *c == '#') {
+			line = next + 1;
+			continue;
+		}
+
+		char *name = c;
+		while (c < next && !is_space(*c)) {
+			c++;
+		}
+		size_t name_len = c - name;
+
+		while (c < next && is_space(*c)) {
+			c++;
+		}
+
+		uint32_t expected = 0;
+		int digits = 0;
+		for (; c < next && !is_space(*c); c++, digits++) {
+			char d = *c;
+			uint32_t v = (d >= '0' && d <= '9') ? d - '0' : (d | 0x20) - 'a' + 10;
+
+			if (v > 0xF) {
+				digits = 0;
+				break;
+			}
+
+			expected = (expected << 4) | v;
+		}
+
+		line = next + 1;
+
+		if (digits == 0 || digits > 8) {
+			ARC_DEBUG(ERR, "Malformed manifest entry for %.*s\n", (int)name_len, name);
+			r = -1;
+			continue;
+		}
+
+		struct ARC_BootModule *module = module_find(name, name_len);
+
+		if (module == NULL) {
+			ARC_DEBUG(ERR, "Manifest lists missing module %.*s\n", (int)name_len, name);
+			r = -1;
+			continue;
+		}
+
+		module->crc32c = crc32c((uint8_t *)(uintptr_t)module->base, module->size);
+		module->flags |= 1 << ARC_BOOT_MODULE_FLAG_CRC32C;
+
+		if (module->crc32c != expected) {
+			ARC_DEBUG(ERR, "%s: CRC32C 0x%08x, expected 0x%08x\n", (char *)(uintptr_t)module->name, module->crc32c, expected);
+			r = -1;
+			continue;
+		}
+
+		ARC_DEBUG(INFO, "\t%s: 0x%08x OK\n", (char *)(uintptr_t)module->name, module->crc32c);
+	}
+
+	return r;
+}
+
+struct ARC_BootModule *module_find_type(uint32_t type) {
+	for (uint32_t i = 0; i < module_count; i++) {
+		if (modules[i].type == type) {
+			return &modules[i];
+		}
+	}
+
+	return NULL;
+}
+
+int module_link_drivers(void *page_tables, struct elf_file *kernel) {
+	// Drivers are placed one after another, starting at the first
+	// 2 MiB boundary after the kernel
+	uint64_t vaddr = ALIGN(elf_get_end(kernel), (uint64_t)0x200000);
+	int r = 0;
+
+	for (uint32_t i = 0; i < module_count; i++) {
+		struct ARC_BootModule *module = &modules[i];
+
+		if (module->type != ARC_BOOT_MODULE_DRIVER) {
+			continue;
+		}
+
+		ARC_DEBUG(INFO, "Linking driver %s at 0x%"PRIx64"\n", (char *)(uintptr_t)module->name, vaddr);
+
+		struct elf_file driver = { 0 };
+		uint64_t phys = 0;
+		uint64_t size = 0;
+
+		if (elf_validate(&driver, (uint8_t *)(uintptr_t)module->base, module->size, ARC_ELF_TYPE_REL) == 0) {
+			size = load_elf_relocatable(page_tables, &driver, kernel, vaddr, &phys);
+		}
+
+		if (size == 0) {
+			ARC_DEBUG(ERR, "Failed to link driver %s\n", (char *)(uintptr_t)module->name);
+			r = -1;
+			continue;
+		}
+
+		module->vaddr = vaddr;
+		module->vsize = size;
+		module->image = phys;
+
+		// The image has been relocated already, so the symbol's
+		// value is its final virtual address
+		if (elf_lookup_symbol(&driver, ARC_BSP_DRIVER_ENTRY_SYMBOL, &module->entry) != 0) {
+			ARC_DEBUG(WARN, "\tNo "ARC_BSP_DRIVER_ENTRY_SYMBOL" in driver\n");
+			module->entry = 0;
+		}
+
+		vaddr += size;
+	}
+
+	return r;
+}
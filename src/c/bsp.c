@@ -29,14 +29,19 @@
 #include <inttypes.h>
 #include <boot/multiboot2.h>
 #include <interface/terminal.h>
+#include <interface/bootlog.h>
 #include <global.h>
 #include <arch/init.h>
 #include <mm/watermark.h>
+#include <mm/mmap.h>
 #include <arch/pager.h>
 #include <elf.h>
 #include <config.h>
 #include <boot/mb2parse.h>
+#include <boot/module.h>
+#include <boot/initramfs.h>
 #include <arch/cpuid.h>
+#include <acpi.h>
 
 // The kernel expects:
 // 	ARC_COM_PORT must be configured for 8N1 transmission at the highest baudrate (done)
@@ -55,6 +60,81 @@ uint64_t pt_root = 0;
 struct ARC_KernelMeta Arc_KernelMeta = { 0 };
 struct ARC_BootMeta Arc_BootMeta = { 0 };
 
+static struct elf_file kernel_file = { 0 };
+
+// Phases of bootstrapping, each ends with the log being flushed and, in
+// splash mode, the progress bar advancing
+enum {
+	BSP_PHASE_PARSE = 0,
+	BSP_PHASE_MMAP,
+	BSP_PHASE_PAGING,
+	BSP_PHASE_ELF,
+	BSP_PHASE_HANDOFF,
+	BSP_PHASE_COUNT,
+};
+
+static void bsp_phase_done(int phase) {
+	bootlog_flush();
+	term_progress(phase + 1, BSP_PHASE_COUNT);
+}
+
+// Part of the HHDM given to the framebuffer's WC mapping
+static uint64_t hhdm_fb_base = 0;
+static uint64_t hhdm_fb_end = 0;
+
+static int bsp_map_hhdm(uint64_t base, uint64_t end) {
+	// Leave the framebuffer's WC mapping in place
+	if (hhdm_fb_end > base && hhdm_fb_base < end) {
+		return bsp_map_hhdm(base, hhdm_fb_base) | bsp_map_hhdm(hhdm_fb_end, end);
+	}
+
+	if (end <= base) {
+		return 0;
+	}
+
+	return pager_map((void *)pt_root, ARC_HHDM_VADDR + base, base, end - base, 1 << ARC_PAGER_RW);
+}
+
+/**
+ * Extend the HHDM over all memory the bootstrapper reserved or allocated.
+ *
+ * The kernel reaches the MMap, the boot metadata, its own image and its
+ * TLS block through the HHDM, so it has to cover them however small
+ * bsp.hhdm is. Page tables made to extend it are allocations too, so
+ * this repeats until none of them land past its end.
+ *
+ * @param uint64_t *hhdm_size - Extent of the HHDM, raised as needed.
+ * @return zero on success.
+ * */
+static int bsp_cover_bootstrap(uint64_t *hhdm_size) {
+	while (1) {
+		watermark_update_mmap();
+
+		struct ARC_MMap *mmap = (struct ARC_MMap *)Arc_KernelMeta.arc_mmap.base;
+		uint64_t end = 0;
+
+		for (uint32_t i = 0; i < Arc_KernelMeta.arc_mmap.len; i++) {
+			if (mmap[i].type == ARC_MEMORY_BOOTSTRAP || mmap[i].type == ARC_MEMORY_BOOTSTRAP_ALLOC) {
+				end = max(end, mmap[i].base + mmap[i].len);
+			}
+		}
+
+		end = ALIGN(end, (uint64_t)PAGE_SIZE);
+
+		if (end <= *hhdm_size) {
+			return 0;
+		}
+
+		ARC_DEBUG(WARN, "Extending HHDM to 0x%"PRIx64" B to cover the bootstrapper's memory\n", end);
+
+		if (bsp_map_hhdm(*hhdm_size, end) != 0) {
+			return -1;
+		}
+
+		*hhdm_size = end;
+	}
+}
+
 uint64_t bsp(uint8_t *mb2i, uint32_t signature) {
 	init_uart();
 
@@ -72,8 +152,39 @@ uint64_t bsp(uint8_t *mb2i, uint32_t signature) {
 		ARC_HANG;
 	}
 
+	// Drawing to an uncached framebuffer is very slow, and everything
+	// logged so far is about to be drawn
+	if (init_arch_fb() != 0) {
+		ARC_DEBUG(INFO, "Framebuffer memory type left as is\n");
+	}
+
+	// Output is batched between phases, this is the first point the
+	// framebuffer is known so show everything logged up to now
+	bsp_phase_done(BSP_PHASE_PARSE);
+
+	// Catch corrupted modules before anything is loaded from them
+	if (module_verify() != 0) {
+		ARC_DEBUG(ERR, "Module verification failed\n");
+		ARC_HANG;
+	}
+
+	// Make sure the kernel can be loaded before doing anything else
+	struct ARC_BootModule *kernel = module_find_type(ARC_BOOT_MODULE_KERNEL);
+
+	if (kernel == NULL) {
+		ARC_DEBUG(ERR, "No kernel module\n");
+		ARC_HANG;
+	}
+
+	if (elf_validate(&kernel_file, (uint8_t *)(uintptr_t)kernel->base, kernel->size, ARC_ELF_TYPE_EXEC) != 0) {
+		ARC_DEBUG(ERR, "Kernel ELF is invalid\n");
+		ARC_HANG;
+	}
+
 	watermark_update_mmap();
 
+	bsp_phase_done(BSP_PHASE_MMAP);
+
 	// Setup architecture
 	init_arch();
 
@@ -84,14 +195,37 @@ uint64_t bsp(uint8_t *mb2i, uint32_t signature) {
 		ARC_HANG;
 	}
 
-	ARC_DEBUG(INFO, "Constructing HHDM at 0x%"PRIx64"\n", ARC_HHDM_VADDR);
-	
-	// Put together HHDM so kernel can access all physical memory
-	if (pager_map((void *)pt_root, ARC_HHDM_VADDR, 0, Arc_BootMeta.mem_size, 1 << ARC_PAGER_RW) != 0) {
+	// Put together HHDM so kernel can access all physical memory, unless
+	// the command line limited it. It always covers what the bootstrapper
+	// hands over
+	uint64_t hhdm_size = Arc_BootMeta.mem_size;
+
+	if (Arc_BootTunables.hhdm_size != 0) {
+		hhdm_size = min(hhdm_size, ALIGN(Arc_BootTunables.hhdm_size, (uint64_t)PAGE_SIZE));
+	}
+
+	ARC_DEBUG(INFO, "Constructing HHDM at 0x%"PRIx64" (0x%"PRIx64" B)\n", ARC_HHDM_VADDR, hhdm_size);
+
+	if (bsp_map_hhdm(0, hhdm_size) != 0 || bsp_cover_bootstrap(&hhdm_size) != 0) {
 		ARC_DEBUG(ERR, "Failed to create HHDM\n");
 		ARC_HANG;
 	}
 
+	// The framebuffer is usually outside of RAM, and so not covered by the
+	// HHDM, give the kernel a WC mapping of the part of it past the HHDM
+	uint64_t fb_base = max(Arc_BootMeta.term.base & ~((uint64_t)PAGE_SIZE - 1), ALIGN(hhdm_size, (uint64_t)PAGE_SIZE));
+	uint64_t fb_end = ALIGN(Arc_BootMeta.term.base + (uint64_t)Arc_BootMeta.term.pitch * Arc_BootMeta.term.height, (uint64_t)PAGE_SIZE);
+
+	if (Arc_BootMeta.term.base != 0 && fb_end > fb_base) {
+		if (pager_map((void *)pt_root, ARC_HHDM_VADDR + fb_base, fb_base, fb_end - fb_base,
+			      (1 << ARC_PAGER_RW) | (ARC_PAGER_PAT_WC << ARC_PAGER_PAT)) != 0) {
+			ARC_DEBUG(WARN, "Failed to map framebuffer into the HHDM\n");
+		} else {
+			hhdm_fb_base = fb_base;
+			hhdm_fb_end = fb_end;
+		}
+	}
+
 	ARC_DEBUG(INFO, "Identity mapping bootstrapper\n")
 
 	// Map bootstrapper image into memory so a page fault is not immediately
@@ -102,11 +236,62 @@ uint64_t bsp(uint8_t *mb2i, uint32_t signature) {
 		ARC_HANG;
 	}
 
+	bsp_phase_done(BSP_PHASE_PAGING);
+
 	// Parse the Kernel ELF file and map it into memory and set 
 	// kernel_entry to the virtual address of where the kernel is
-	kernel_entry = load_elf((void *)pt_root, (uint8_t *)((uintptr_t)Arc_KernelMeta.kernel_elf));
+	uint32_t elf_flags = 0;
 
-	watermark_update_mmap();
+	if (Arc_BootTunables.kernel_contiguous) {
+		// Place the kernel in a contiguous 2 MiB aligned block so it can be
+		// mapped using 2 MiB pages
+		elf_flags |= 1 << ARC_ELF_LOAD_CONTIGUOUS;
+	}
+
+	kernel_entry = load_elf((void *)pt_root, &kernel_file, elf_flags);
+
+	if (kernel_entry == (uint64_t)-1) {
+		ARC_DEBUG(ERR, "Failed to load kernel\n");
+		ARC_HANG;
+	}
+
+	// Relocate driver modules against the kernel so they can be
+	// initialized without any dynamic linking
+	if (module_link_drivers((void *)pt_root, &kernel_file) != 0) {
+		ARC_DEBUG(ERR, "Failed to link one or more drivers\n");
+	}
+
+	bsp_phase_done(BSP_PHASE_ELF);
+
+	// Move the initramfs out of wherever GRUB placed it, so it can be
+	// mapped with 2 MiB pages
+	if (Arc_BootTunables.initramfs_relocate && initramfs_relocate((void *)pt_root) != 0) {
+		ARC_DEBUG(WARN, "Initramfs left in place\n");
+	}
+
+	// Save the kernel from walking the archive for every lookup
+	if (initramfs_index() != 0) {
+		ARC_DEBUG(WARN, "Initramfs will not be indexed\n");
+	}
+
+	// Hand the kernel a directory of the ACPI tables so it does not need
+	// to walk them on the boot critical path
+	if (init_acpi() != 0) {
+		ARC_DEBUG(WARN, "ACPI tables will not be summarised\n");
+	}
+
+	// The kernel, its TLS block, the initramfs index and the ACPI summary
+	// were allocated after the HHDM was made
+	if (bsp_cover_bootstrap(&hhdm_size) != 0) {
+		ARC_DEBUG(ERR, "Failed to extend HHDM\n");
+		ARC_HANG;
+	}
+
+	// Nothing is allocated past this point, give back the unused
+	// part of the map's storage
+	if (mmap_compact() != 0) {
+		ARC_DEBUG(WARN, "Failed to compact ARC_MMap\n");
+	}
 
 	const char *names[] = {
 		[ARC_MEMORY_AVAILABLE] = "Available",
@@ -127,6 +312,10 @@ uint64_t bsp(uint8_t *mb2i, uint32_t signature) {
 
 	ARC_DEBUG(INFO, "Finished bootstrapping, returning to assembly to setup long mode and jump to kernel (0x%"PRIx64") %"PRIx64"\n", kernel_entry);
 
+	// Make sure everything logged is on screen before the kernel takes
+	// over the framebuffer
+	bsp_phase_done(BSP_PHASE_HANDOFF);
+
 	// Jump back to the assembly phase, which will enable paging and put the
 	// system into long mode before jumping to the kernel
 	return kernel_entry;
@@ -0,0 +1,137 @@
+/**
+ * @file crc32c.c
+ *
+ * @author awewsomegamer <awewsomegamer@gmail.com>
+ *
+ * @LICENSE
+ * Arctan-OS/BSP-GRUB - GRUB bootstrapper for Arctan-OS/Kernel
+ * Copyright (C) 2023-2025 awewsomegamer
+ *
+ * This file is part of Arctan-OS/BSP-GRUB
+ *
+ * Arctan is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 2
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ * @DESCRIPTION
+ * CRC32C implementation, uses the SSE4.2 CRC32 instruction if it is
+ * available and falls back to slicing-by-8 otherwise.
+*/
+#include <crc32c.h>
+#include <global.h>
+#include <stdbool.h>
+
+#if defined(ARC_TARGET_ARCH_X86_64) || defined(ARC_TARGET_ARCH_X86)
+#include <cpuid.h>
+#endif
+
+#define CRC32C_POLY 0x82F63B78
+
+static uint32_t crc32c_table[8][256] = { 0 };
+
+#if defined(ARC_TARGET_ARCH_X86_64) || defined(ARC_TARGET_ARCH_X86)
+static bool crc32c_hw = false;
+#endif
+
+void init_crc32c() {
+	for (uint32_t i = 0; i < 256; i++) {
+		uint32_t crc = i;
+
+		for (int j = 0; j < 8; j++) {
+			crc = (crc >> 1) ^ (CRC32C_POLY & -(crc & 1));
+		}
+
+		crc32c_table[0][i] = crc;
+	}
+
+	for (uint32_t i = 0; i < 256; i++) {
+		for (int j = 1; j < 8; j++) {
+			uint32_t prev = crc32c_table[j - 1][i];
+			crc32c_table[j][i] = (prev >> 8) ^ crc32c_table[0][prev & 0xFF];
+		}
+	}
+
+#if defined(ARC_TARGET_ARCH_X86_64) || defined(ARC_TARGET_ARCH_X86)
+	uint32_t eax, ebx, ecx, edx;
+	__cpuid(0x1, eax, ebx, ecx, edx);
+
+	// SSE4.2
+	crc32c_hw = (ecx >> 20) & 1;
+
+	ARC_DEBUG(INFO, "CRC32C using %s\n", crc32c_hw ? "CRC32 instruction" : "slicing-by-8");
+#else
+	ARC_DEBUG(INFO, "CRC32C using slicing-by-8\n");
+#endif
+}
+
+#if defined(ARC_TARGET_ARCH_X86_64) || defined(ARC_TARGET_ARCH_X86)
+static uint32_t crc32c_hardware(uint32_t crc, const uint8_t *data, size_t size) {
+	while (size > 0 && ((uintptr_t)data & 3) != 0) {
+		__asm__("crc32 %0, byte ptr [%1]" : "+r"(crc) : "r"(data));
+		data++;
+		size--;
+	}
+
+	while (size >= 4) {
+		__asm__("crc32 %0, dword ptr [%1]" : "+r"(crc) : "r"(data));
+		data += 4;
+		size -= 4;
+	}
+
+	while (size > 0) {
+		__asm__("crc32 %0, byte ptr [%1]" : "+r"(crc) : "r"(data));
+		data++;
+		size--;
+	}
+
+	return crc;
+}
+#endif
+
+static uint32_t crc32c_software(uint32_t crc, const uint8_t *data, size_t size) {
+	while (size > 0 && ((uintptr_t)data & 3) != 0) {
+		crc = crc32c_table[0][(crc ^ *data++) & 0xFF] ^ (crc >> 8);
+		size--;
+	}
+
+	while (size >= 8) {
+		uint32_t lo = *(uint32_t *)data ^ crc;
+		uint32_t hi = *(uint32_t *)(data + 4);
+
+		crc = crc32c_table[7][lo & 0xFF] ^ crc32c_table[6][(lo >> 8) & 0xFF]
+		    ^ crc32c_table[5][(lo >> 16) & 0xFF] ^ crc32c_table[4][lo >> 24]
+		    ^ crc32c_table[3][hi & 0xFF] ^ crc32c_table[2][(hi >> 8) & 0xFF]
+		    ^ crc32c_table[1][(hi >> 16) & 0xFF] ^ crc32c_table[0][hi >> 24];
+
+		data += 8;
+		size -= 8;
+	}
+
+	while (size > 0) {
+		crc = crc32c_table[0][(crc ^ *data++) & 0xFF] ^ (crc >> 8);
+		size--;
+	}
+
+	return crc;
+}
+
+uint32_t crc32c(const uint8_t *data, size_t size) {
+	uint32_t crc = 0xFFFFFFFF;
+
+#if defined(ARC_TARGET_ARCH_X86_64) || defined(ARC_TARGET_ARCH_X86)
+	if (crc32c_hw) {
+		return crc32c_hardware(crc, data, size) ^ 0xFFFFFFFF;
+	}
+#endif
+
+	return crc32c_software(crc, data, size) ^ 0xFFFFFFFF;
+}
@@ -25,11 +25,14 @@
  * @DESCRIPTION
  * Simple IDT to handle errors which may occur when getting to the kernel.
 */
+#define ARC_DEBUG_SUBSYS ARC_DEBUG_SUBSYS_ELF
+
 #include <elf.h>
 #include <global.h>
 #include <inttypes.h>
 #include <mm/watermark.h>
 #include <arch/pager.h>
+#include <config.h>
 
 #define SHT_NULL     0
 #define SHT_PROGBITS 1
@@ -44,6 +47,38 @@
 #define SHT_SHLIB    10
 #define SHT_DYNSYM   11
 
+#define SHF_WRITE      0x1
+#define SHF_ALLOC      0x2
+#define SHF_TLS        0x400
+
+#define PT_LOAD        1
+#define PT_TLS         7
+
+#define SHN_UNDEF      0
+#define SHN_ABS        0xFFF1
+#define SHN_COMMON     0xFFF2
+
+#define ET_REL         ARC_ELF_TYPE_REL
+#define ET_EXEC        ARC_ELF_TYPE_EXEC
+
+#define EM_X86_64      62
+
+#define R_X86_64_NONE  0
+#define R_X86_64_64    1
+#define R_X86_64_PC32  2
+#define R_X86_64_PLT32 4
+#define R_X86_64_32    10
+#define R_X86_64_32S   11
+#define R_X86_64_PC64  24
+
+#define ELF64_R_SYM(i)  ((uint32_t)((i) >> 32))
+#define ELF64_R_TYPE(i) ((uint32_t)((i) & 0xFFFFFFFF))
+
+#define STB_LOCAL      0
+#define ELF64_ST_BIND(i) ((i) >> 4)
+
+#define ELF_MAGIC      0x464C457F
+
 #define EI_MAG0        0
 #define EI_MAG1        1
 #define EI_MAG2        2
@@ -54,7 +89,9 @@
 #define CLASS_64       2
 
 #define EI_DATA        5
+#define DATA_LSB       1
 #define EI_VERSION     6
+#define EV_CURRENT     1
 
 #define EI_OSABI       7
 #define ABI_SYSV       0
@@ -149,39 +186,261 @@ struct Elf64_Phdr {
 	Elf64_Xword p_align; /* Alignment of segment */
 }__attribute__((packed));
 
-uint64_t elf_load64(void *page_tables, uint8_t *data) {
-	ARC_DEBUG(INFO, "Loading 64-bit ELF file (%p)\n", data);
+static int elf_in_bounds(uint64_t offset, uint64_t length, uint64_t size) {
+	return offset <= size && length <= size - offset;
+}
+
+int elf_validate(struct elf_file *file, uint8_t *data, uint64_t size, uint32_t type) {
+	memset(file, 0, sizeof(*file));
+
+	if (data == NULL || size < sizeof(struct Elf64_Ehdr)) {
+		ARC_DEBUG(ERR, "ELF file missing or smaller than its header\n");
+		return -1;
+	}
 
 	struct Elf64_Ehdr *header = (struct Elf64_Ehdr *)data;
 
-	uint64_t entry_addr = header->e_entry;
+	if (*(uint32_t *)header->e_ident != ELF_MAGIC) {
+		ARC_DEBUG(ERR, "Bad ELF magic\n");
+		return -2;
+	}
 
-	ARC_DEBUG(INFO, "Entry: %"PRIx64"\n", entry_addr);
+	if (header->e_ident[EI_CLASS] != CLASS_64 || header->e_ident[EI_DATA] != DATA_LSB
+	    || header->e_ident[EI_VERSION] != EV_CURRENT || header->e_machine != EM_X86_64) {
+		ARC_DEBUG(ERR, "ELF file is not 64-bit little endian x86-64\n");
+		return -3;
+	}
+
+	if (header->e_type != type) {
+		ARC_DEBUG(ERR, "ELF file is of type %d, expected %d\n", header->e_type, type);
+		return -4;
+	}
+
+	if (header->e_phnum != 0 && (header->e_phentsize != sizeof(struct Elf64_Phdr)
+	    || !elf_in_bounds(header->e_phoff, (uint64_t)header->e_phnum * sizeof(struct Elf64_Phdr), size))) {
+		ARC_DEBUG(ERR, "Program header table out of bounds\n");
+		return -5;
+	}
+
+	if (header->e_shnum != 0 && (header->e_shentsize != sizeof(struct Elf64_Shdr)
+	    || !elf_in_bounds(header->e_shoff, (uint64_t)header->e_shnum * sizeof(struct Elf64_Shdr), size)
+	    || header->e_shstrndx >= header->e_shnum)) {
+		ARC_DEBUG(ERR, "Section header table out of bounds\n");
+		return -6;
+	}
+
+	file->data = data;
+	file->size = size;
+	file->header = header;
+	file->phdrs = header->e_phnum != 0 ? (struct Elf64_Phdr *)(data + header->e_phoff) : NULL;
+	file->shdrs = header->e_shnum != 0 ? (struct Elf64_Shdr *)(data + header->e_shoff) : NULL;
+	file->phnum = header->e_phnum;
+	file->shnum = header->e_shnum;
+	file->load_base = UINT64_MAX;
+
+	for (uint32_t i = 0; i < file->phnum; i++) {
+		struct Elf64_Phdr *segment = &file->phdrs[i];
+
+		if (segment->p_type != PT_LOAD && segment->p_type != PT_TLS) {
+			continue;
+		}
+
+		if (!elf_in_bounds(segment->p_offset, segment->p_filesz, size) || segment->p_filesz > segment->p_memsz
+		    || segment->p_vaddr + segment->p_memsz < segment->p_vaddr
+		    || (segment->p_align & (segment->p_align - 1)) != 0) {
+			ARC_DEBUG(ERR, "Segment %d is malformed\n", i);
+			return -7;
+		}
+
+		if (segment->p_type == PT_TLS) {
+			file->tls = segment;
+			continue;
+		}
+
+		if (segment->p_memsz != 0) {
+			file->load_base = min(file->load_base, segment->p_vaddr);
+			file->load_end = max(file->load_end, segment->p_vaddr + segment->p_memsz);
+		}
+	}
+
+	for (uint32_t i = 0; i < file->shnum; i++) {
+		struct Elf64_Shdr *section = &file->shdrs[i];
+
+		if (section->sh_type != SHT_NOBITS && section->sh_type != SHT_NULL
+		    && !elf_in_bounds(section->sh_offset, section->sh_size, size)) {
+			ARC_DEBUG(ERR, "Section %d out of bounds\n", i);
+			return -8;
+		}
+
+		if (section->sh_link >= file->shnum || ((section->sh_addralign & (section->sh_addralign - 1)) != 0)) {
+			ARC_DEBUG(ERR, "Section %d is malformed\n", i);
+			return -9;
+		}
+
+		if ((section->sh_flags & SHF_ALLOC) != 0 && (section->sh_flags & SHF_TLS) == 0) {
+			file->section_end = max(file->section_end, section->sh_addr + section->sh_size);
+		}
+
+		switch (section->sh_type) {
+			case SHT_SYMTAB: {
+				struct Elf64_Shdr *strings = &file->shdrs[section->sh_link];
+
+				// The string table may come after this section, so its
+				// bounds have not necessarily been checked yet
+				if (section->sh_entsize != sizeof(struct Elf64_Sym) || strings->sh_type != SHT_STRTAB
+				    || strings->sh_size == 0 || !elf_in_bounds(strings->sh_offset, strings->sh_size, size)
+				    || file->data[strings->sh_offset + strings->sh_size - 1] != 0) {
+					ARC_DEBUG(ERR, "Symbol table %d is malformed\n", i);
+					return -10;
+				}
+
+				if (file->symtab == NULL) {
+					file->symtab = section;
+					file->symbols = (struct Elf64_Sym *)(data + section->sh_offset);
+					file->symbol_count = section->sh_size / sizeof(struct Elf64_Sym);
+					file->strtab = (char *)(data + strings->sh_offset);
+					file->strtab_size = strings->sh_size;
+				}
+
+				break;
+			}
+
+			case SHT_RELA: {
+				if (section->sh_entsize != sizeof(struct Elf64_Rela) || section->sh_info >= file->shnum
+				    || file->shdrs[section->sh_link].sh_type != SHT_SYMTAB) {
+					ARC_DEBUG(ERR, "Relocation section %d is malformed\n", i);
+					return -11;
+				}
+
+				break;
+			}
+		}
+	}
 
-	uint32_t section_count = header->e_shnum;
-	ARC_DEBUG(INFO, "Mapping sections (%d sections):\n", section_count);
+	if (file->load_base == UINT64_MAX) {
+		file->load_base = 0;
+	}
+
+	return 0;
+}
+
+/**
+ * Build the boot CPU's TLS block from the kernel's PT_TLS segment.
+ *
+ * Uses the x86-64 variant II layout, the TLS image ends at the thread
+ * pointer which points to a TCB whose first word points to itself. The
+ * thread pointer handed to the kernel is the HHDM address of the TCB.
+ * */
+static int elf_build_tls(struct elf_file *file) {
+	struct Elf64_Phdr *tls = file->tls;
+
+	uint64_t align = max(tls->p_align, (uint64_t)sizeof(uint64_t));
+	uint64_t tls_size = ALIGN(tls->p_memsz, align);
+	// The TCB only has to hold the self pointer
+	uint64_t block_size = ALIGN(tls_size + sizeof(uint64_t), PAGE_SIZE);
+
+	uint8_t *block = (uint8_t *)alloc_aligned(block_size, 0x200000);
+
+	if (block == NULL) {
+		ARC_DEBUG(ERR, "Failed to allocate TLS block\n");
+		return -1;
+	}
+
+	memset(block, 0, block_size);
+	memcpy(block, file->data + tls->p_offset, tls->p_filesz);
+
+	uint64_t tp = ARC_HHDM_VADDR + (uintptr_t)block + tls_size;
+	*(uint64_t *)(block + tls_size) = tp;
+
+	Arc_KernelMeta.tls.addr = tls->p_vaddr;
+	Arc_KernelMeta.tls.filesz = tls->p_filesz;
+	Arc_KernelMeta.tls.memsz = tls->p_memsz;
+	Arc_KernelMeta.tls.align = tls->p_align;
+	Arc_KernelMeta.tls.block = (uintptr_t)block;
+	Arc_KernelMeta.tls.tp = tp;
+
+	ARC_DEBUG(INFO, "TLS template 0x%"PRIx64" (0x%"PRIx64" / 0x%"PRIx64" B), block at %p, TP 0x%"PRIx64"\n",
+		  tls->p_vaddr, tls->p_filesz, tls->p_memsz, block, tp);
+
+	return 0;
+}
+
+/**
+ * Copy the PT_LOAD segments into one physically contiguous, 2 MiB aligned
+ * block and map it.
+ *
+ * The block mirrors the virtual layout of the segments starting from the
+ * 2 MiB boundary below the lowest segment, so the image can be mapped
+ * with 2 MiB pages.
+ * */
+static int elf_load64_contiguous(void *page_tables, struct elf_file *file) {
+	if (file->load_end == 0) {
+		ARC_DEBUG(ERR, "No PT_LOAD segments\n");
+		return -1;
+	}
+
+	uint64_t vbase = file->load_base & ~((uint64_t)0x200000 - 1);
+	uint64_t size = ALIGN(file->load_end - vbase, (uint64_t)0x200000);
+	uint8_t *block = (uint8_t *)alloc_aligned(size, 0x200000);
+
+	if (block == NULL) {
+		ARC_DEBUG(ERR, "Failed to allocate 0x%"PRIx64" B for kernel image\n", size);
+		return -1;
+	}
 
-	struct Elf64_Shdr strings = ((struct Elf64_Shdr *)(data + header->e_shoff))[header->e_shstrndx];
+	ARC_DEBUG(INFO, "Copying segments into %p (0x%"PRIx64" B) for 0x%"PRIx64"\n", block, size, vbase);
 
-	uint64_t phys_address = 0;
-	for (uint32_t i = 0; i < section_count; i++) {
-		struct Elf64_Shdr section_header = ((struct Elf64_Shdr *)(data + header->e_shoff))[i];
+	for (uint32_t i = 0; i < file->phnum; i++) {
+		struct Elf64_Phdr *segment = &file->phdrs[i];
 
-		uint64_t load_base = section_header.sh_addr;
-		uint64_t load_size = ALIGN(section_header.sh_size, PAGE_SIZE);
+		if (segment->p_type != PT_LOAD || segment->p_memsz == 0) {
+			continue;
+		}
+
+		uint8_t *dest = block + (segment->p_vaddr - vbase);
+		memcpy(dest, file->data + segment->p_offset, segment->p_filesz);
+		memset(dest + segment->p_filesz, 0, segment->p_memsz - segment->p_filesz);
+	}
+
+	if (pager_map(page_tables, vbase, (uintptr_t)block, size, 1 << ARC_PAGER_RW) != 0) {
+		ARC_DEBUG(ERR, "Failed to map kernel image\n");
+		return -1;
+	}
+
+	return 0;
+}
+
+/**
+ * Map each allocated section of the ELF file in place.
+ * */
+static int elf_load64_sections(void *page_tables, struct elf_file *file) {
+	ARC_DEBUG(INFO, "Mapping sections (%d sections):\n", file->shnum);
+
+	for (uint32_t i = 0; i < file->shnum; i++) {
+		struct Elf64_Shdr *section_header = &file->shdrs[i];
+
+		uint64_t load_base = section_header->sh_addr;
+		uint64_t load_size = ALIGN(section_header->sh_size, PAGE_SIZE);
 
-		ARC_DEBUG(INFO, "\t%3d: 0x%016"PRIx64", 0x%016"PRIx64" B | Type: %d\n", i, load_base, load_size, section_header.sh_type);
+		ARC_DEBUG(INFO, "\t%3d: 0x%016"PRIx64", 0x%016"PRIx64" B | Type: %d\n", i, load_base, load_size, section_header->sh_type);
 
 		if (load_base == 0 || load_size == 0) {
 			ARC_DEBUG(INFO, "\t\tSkipping as load_base or size is 0\n");
 			continue;
 		}
 
-		uint64_t phys = (uint64_t)data + section_header.sh_offset;
+		if (section_header->sh_type == SHT_NOBITS && (section_header->sh_flags & SHF_TLS) != 0) {
+			// .tbss takes up no space in the image, it is part
+			// of the TLS template
+			ARC_DEBUG(INFO, "\t\tSkipping TLS NOBITS section\n");
+			continue;
+		}
 
-		if (section_header.sh_type == SHT_NOBITS) {
-			phys = (uint64_t)alloc(load_size);
-			memset((void *)phys, 0, load_size);
+		uint64_t phys = (uintptr_t)file->data + section_header->sh_offset;
+
+		if (section_header->sh_type == SHT_NOBITS) {
+			phys = (uintptr_t)alloc(load_size);
+			memset((void *)(uintptr_t)phys, 0, load_size);
 		}
 
 		if (pager_map(page_tables, load_base, phys, load_size, 1 << ARC_PAGER_RW) != 0) {
@@ -189,16 +448,291 @@ uint64_t elf_load64(void *page_tables, uint8_t *data) {
 		}
 	}
 
+	return 0;
+}
+
+uint64_t load_elf(void *page_tables, struct elf_file *file, uint32_t flags) {
+	ARC_DEBUG(INFO, "Loading 64-bit ELF file (%p)\n", file->data);
+
+	uint64_t entry_addr = file->header->e_entry;
+
+	ARC_DEBUG(INFO, "Entry: %"PRIx64"\n", entry_addr);
+
+	int r = 0;
+	if (MASKED_READ(flags, ARC_ELF_LOAD_CONTIGUOUS, 1) == 1) {
+		r = elf_load64_contiguous(page_tables, file);
+	} else {
+		r = elf_load64_sections(page_tables, file);
+	}
+
+	if (r != 0) {
+		return -1;
+	}
+
+	if (file->tls != NULL && elf_build_tls(file) != 0) {
+		return -1;
+	}
+
 	return entry_addr;
 }
 
-uint64_t load_elf(void *page_tables, uint8_t *data) {
-	struct Elf64_Ehdr *header = (struct Elf64_Ehdr *)data;
+/**
+ * Get the address of a section, as assigned by load_elf_relocatable for
+ * relocatable files.
+ * */
+static uint64_t elf_section_addr(struct elf_file *file, uint32_t index) {
+	if (file->section_addrs != NULL) {
+		return file->section_addrs[index];
+	}
+
+	return file->shdrs[index].sh_addr;
+}
+
+uint64_t elf_get_end(struct elf_file *file) {
+	return file->section_end;
+}
+
+int elf_lookup_symbol(struct elf_file *file, char *name, uint64_t *value) {
+	struct Elf64_Sym *symbols = file->symbols;
+
+	for (uint32_t i = 0; i < file->symbol_count; i++) {
+		if (symbols[i].st_shndx == SHN_UNDEF || ELF64_ST_BIND(symbols[i].st_info) == STB_LOCAL
+		    || symbols[i].st_name >= file->strtab_size || strcmp(file->strtab + symbols[i].st_name, name) != 0) {
+			continue;
+		}
+
+		*value = symbols[i].st_value;
+
+		// Symbols of relocatable files are relative to their section
+		if (file->header->e_type == ET_REL && symbols[i].st_shndx < file->shnum) {
+			*value += elf_section_addr(file, symbols[i].st_shndx);
+		}
+
+		return 0;
+	}
+
+	return -1;
+}
+
+/**
+ * Get the value of a symbol of a relocatable ELF file.
+ *
+ * Section addresses of the relocatable file must have already been
+ * assigned. Undefined symbols are resolved against the kernel.
+ * */
+static int elf_rel_symbol_value(struct elf_file *file, uint32_t index, struct elf_file *kernel, uint64_t *value) {
+	if (index >= file->symbol_count) {
+		ARC_DEBUG(ERR, "Symbol index %d out of bounds\n", index);
+		return -1;
+	}
+
+	struct Elf64_Sym *symbol = &file->symbols[index];
+
+	if (symbol->st_name >= file->strtab_size) {
+		ARC_DEBUG(ERR, "Symbol %d has a bad name\n", index);
+		return -1;
+	}
+
+	char *name = file->strtab + symbol->st_name;
+
+	switch (symbol->st_shndx) {
+		case SHN_UNDEF: {
+			if (elf_lookup_symbol(kernel, name, value) != 0) {
+				ARC_DEBUG(ERR, "Unresolved symbol %s\n", name);
+				return -1;
+			}
+
+			return 0;
+		}
+
+		case SHN_ABS: {
+			*value = symbol->st_value;
+			return 0;
+		}
+
+		case SHN_COMMON: {
+			ARC_DEBUG(ERR, "Common symbol %s, build drivers with -fno-common\n", name);
+			return -1;
+		}
+	}
 
-	if (header->e_ident[EI_CLASS] != CLASS_64) {
-		ARC_DEBUG(ERR, "ELF file is not 64-bit\n");
+	if (symbol->st_shndx >= file->shnum) {
+		ARC_DEBUG(ERR, "Symbol %s has bad section index %d\n", name, symbol->st_shndx);
 		return -1;
 	}
 
-	return elf_load64(page_tables, data);
+	*value = elf_section_addr(file, symbol->st_shndx) + symbol->st_value;
+
+	return 0;
+}
+
+uint64_t load_elf_relocatable(void *page_tables, struct elf_file *file, struct elf_file *kernel, uint64_t vaddr, uint64_t *phys) {
+	struct Elf64_Shdr *sections = file->shdrs;
+
+	// The section headers belong to the module handed to the kernel,
+	// which must still match its manifest, so addresses are kept aside
+	uint64_t *addrs = (uint64_t *)alloc(file->shnum * sizeof(uint64_t));
+
+	if (addrs == NULL) {
+		ARC_DEBUG(ERR, "Failed to allocate section addresses\n");
+		return 0;
+	}
+
+	// Lay out allocated sections one after another starting at vaddr
+	uint64_t size = 0;
+	for (uint32_t i = 0; i < file->shnum; i++) {
+		addrs[i] = 0;
+
+		if (sections[i].sh_type == SHT_REL) {
+			ARC_DEBUG(ERR, "SHT_REL relocations are not supported\n");
+			return 0;
+		}
+
+		if ((sections[i].sh_flags & SHF_ALLOC) == 0 || sections[i].sh_size == 0) {
+			continue;
+		}
+
+		uint64_t align = max(sections[i].sh_addralign, (uint64_t)1);
+		size = (size + align - 1) & ~(align - 1);
+		addrs[i] = vaddr + size;
+		size += sections[i].sh_size;
+	}
+
+	file->section_addrs = addrs;
+
+	size = ALIGN(size, PAGE_SIZE);
+
+	if (size == 0) {
+		ARC_DEBUG(ERR, "Relocatable has no allocated sections\n");
+		return 0;
+	}
+
+	uint8_t *image = (uint8_t *)alloc(size);
+
+	if (image == NULL) {
+		ARC_DEBUG(ERR, "Failed to allocate 0x%"PRIx64" B for relocatable\n", size);
+		return 0;
+	}
+
+	memset(image, 0, size);
+
+	for (uint32_t i = 0; i < file->shnum; i++) {
+		if ((sections[i].sh_flags & SHF_ALLOC) == 0 || sections[i].sh_size == 0
+		    || sections[i].sh_type == SHT_NOBITS) {
+			continue;
+		}
+
+		memcpy(image + (addrs[i] - vaddr), file->data + sections[i].sh_offset, sections[i].sh_size);
+	}
+
+	// Apply relocations to allocated sections
+	for (uint32_t i = 0; i < file->shnum; i++) {
+		if (sections[i].sh_type != SHT_RELA) {
+			continue;
+		}
+
+		uint32_t target_index = sections[i].sh_info;
+		struct Elf64_Shdr *target = &sections[target_index];
+
+		if ((target->sh_flags & SHF_ALLOC) == 0) {
+			continue;
+		}
+
+		if (&sections[sections[i].sh_link] != file->symtab) {
+			ARC_DEBUG(ERR, "Relocations against secondary symbol table\n");
+			return 0;
+		}
+
+		struct Elf64_Rela *relocations = (struct Elf64_Rela *)(file->data + sections[i].sh_offset);
+		uint32_t count = sections[i].sh_size / sizeof(struct Elf64_Rela);
+
+		for (uint32_t j = 0; j < count; j++) {
+			struct Elf64_Rela rela = relocations[j];
+			uint32_t type = ELF64_R_TYPE(rela.r_info);
+
+			if (type == R_X86_64_NONE) {
+				continue;
+			}
+
+			uint64_t width = (type == R_X86_64_64 || type == R_X86_64_PC64) ? sizeof(uint64_t) : sizeof(uint32_t);
+
+			if (!elf_in_bounds(rela.r_offset, width, target->sh_size)) {
+				ARC_DEBUG(ERR, "Relocation offset 0x%"PRIx64" out of bounds\n", rela.r_offset);
+				return 0;
+			}
+
+			uint64_t s = 0;
+			if (elf_rel_symbol_value(file, ELF64_R_SYM(rela.r_info), kernel, &s) != 0) {
+				return 0;
+			}
+
+			uint64_t p = addrs[target_index] + rela.r_offset;
+			uint8_t *location = image + (p - vaddr);
+			uint64_t result = 0;
+
+			switch (type) {
+				case R_X86_64_64: {
+					*(uint64_t *)location = s + rela.r_addend;
+					continue;
+				}
+
+				case R_X86_64_PC64: {
+					*(uint64_t *)location = s + rela.r_addend - p;
+					continue;
+				}
+
+				case R_X86_64_PC32:
+				case R_X86_64_PLT32: {
+					result = s + rela.r_addend - p;
+
+					if ((int64_t)result != (int32_t)result) {
+						break;
+					}
+
+					*(uint32_t *)location = (uint32_t)result;
+					continue;
+				}
+
+				case R_X86_64_32: {
+					result = s + rela.r_addend;
+
+					if (result != (uint32_t)result) {
+						break;
+					}
+
+					*(uint32_t *)location = (uint32_t)result;
+					continue;
+				}
+
+				case R_X86_64_32S: {
+					result = s + rela.r_addend;
+
+					if ((int64_t)result != (int32_t)result) {
+						break;
+					}
+
+					*(uint32_t *)location = (uint32_t)result;
+					continue;
+				}
+
+				default: {
+					ARC_DEBUG(ERR, "Unsupported relocation type %d\n", type);
+					return 0;
+				}
+			}
+
+			ARC_DEBUG(ERR, "Relocation (%d) at 0x%"PRIx64" truncated\n", type, p);
+
+			return 0;
+		}
+	}
+
+	if (pager_map(page_tables, vaddr, (uintptr_t)image, size, 1 << ARC_PAGER_RW) != 0) {
+		ARC_DEBUG(ERR, "Failed to map relocatable\n");
+		return 0;
+	}
+
+	*phys = (uintptr_t)image;
+
+	return size;
 }
@@ -0,0 +1,47 @@
+/**
+ * @file acpi.h
+ *
+ * @author awewsomegamer <awewsomegamer@gmail.com>
+ *
+ * @LICENSE
+ * Arctan-OS/BSP-GRUB - GRUB bootstrapper for Arctan-OS/Kernel
+ * Copyright (C) 2023-2025 awewsomegamer
+ *
+ * This file is part of Arctan-OS/BSP-GRUB
+ *
+ * Arctan is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 2
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ * @DESCRIPTION
+ * Functions for walking the ACPI tables once and summarising the ones the
+ * kernel needs early.
+*/
+#ifndef ARC_ACPI_H
+#define ARC_ACPI_H
+
+#include <stdint.h>
+
+/**
+ * Walk the RSDT/XSDT and summarise the tables for the kernel.
+ *
+ * Every table is checksummed and recorded in a directory of
+ * ARC_ACPITable entries. The MADT, HPET, MCFG and SRAT are decoded into
+ * the LAPIC list, HPET base, ECAM segment list and memory affinity list
+ * in Arc_KernelMeta.acpi. Tables above 4 GiB cannot be read by the
+ * bootstrapper and are recorded as unverified.
+ *
+ * @return Error code (0: success, or no RSDP was given).
+ * */
+int init_acpi();
+
+#endif
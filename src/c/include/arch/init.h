@@ -33,4 +33,12 @@
 
 int init_arch();
 
+/**
+ * Make writing to the framebuffer in Arc_BootMeta.term as fast as the
+ * architecture allows.
+ *
+ * @return Error code (0: success).
+ * */
+int init_arch_fb();
+
 #endif
\ No newline at end of file
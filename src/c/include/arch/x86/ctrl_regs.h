@@ -50,4 +50,13 @@ extern uint64_t _x86_RDMSR(uint32_t msr);
 // Value: EDX:EAX
 extern void _x86_WRMSR(uint32_t msr, uint64_t value);
 
+// Returns in EDX:EAX
+extern uint64_t _x86_RDTSC();
+
+// Disable caching (CR0.CD) and write back and invalidate the caches, as
+// needed around changes to the MTRRs
+extern void _x86_cache_disable();
+// Write back and invalidate the caches and enable caching again
+extern void _x86_cache_enable();
+
 #endif
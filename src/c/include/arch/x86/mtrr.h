@@ -0,0 +1,57 @@
+/**
+ * @file mtrr.h
+ *
+ * @author awewsomegamer <awewsomegamer@gmail.com>
+ *
+ * @LICENSE
+ * Arctan-OS/BSP-GRUB - GRUB bootstrapper for Arctan-OS/Kernel
+ * Copyright (C) 2023-2025 awewsomegamer
+ *
+ * This file is part of Arctan-OS/BSP-GRUB
+ *
+ * Arctan is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 2
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ * @DESCRIPTION
+ * Detection and programming of the x86 memory type range registers.
+*/
+#ifndef ARC_ARCH_X86_MTRR_H
+#define ARC_ARCH_X86_MTRR_H
+
+#include <stdint.h>
+
+/**
+ * Read the MTRR capabilities and current layout.
+ *
+ * Called by check_cpuid when CPUID reports MTRRs. The layout is recorded
+ * in Arc_KernelMeta.mtrr.
+ *
+ * @return Error code (0: success).
+ * */
+int mtrr_detect();
+
+/**
+ * Make a range of physical memory write-combining.
+ *
+ * The range is covered with free variable MTRRs, using as many aligned
+ * power of two blocks as needed so nothing outside of it is touched. If
+ * there are not enough free MTRRs, only the start of the range is
+ * covered. Nothing is changed if another MTRR already overlaps the range.
+ *
+ * @param uint64_t base - Physical base of the range.
+ * @param uint64_t size - Size of the range in bytes.
+ * @return Error code (0: at least part of the range is WC).
+ * */
+int mtrr_set_wc(uint64_t base, uint64_t size);
+
+#endif
@@ -0,0 +1,67 @@
+/**
+ * @file cmdline.h
+ *
+ * @author awewsomegamer <awewsomegamer@gmail.com>
+ *
+ * @LICENSE
+ * Arctan-OS/BSP-GRUB - GRUB bootstrapper for Arctan-OS/Kernel
+ * Copyright (C) 2023-2025 awewsomegamer
+ *
+ * This file is part of Arctan-OS/BSP-GRUB
+ *
+ * Arctan is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 2
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ * @DESCRIPTION
+ * Parser turning the kernel command line into the tunables used by the
+ * bootstrapper.
+*/
+#ifndef ARC_BOOT_CMDLINE_H
+#define ARC_BOOT_CMDLINE_H
+
+#include <arctan.h>
+
+// Prefix of the options meant for the bootstrapper, all other options
+// are left to the kernel
+#define ARC_BSP_CMDLINE_PREFIX "bsp."
+
+/**
+ * Parse the command line into Arc_BootTunables.
+ *
+ * Options take the form bsp.<key>=<value> and are separated by spaces,
+ * a bare bsp.<key> sets a boolean. The string is not modified and no
+ * memory is allocated. The string is handed to the kernel, as are the
+ * tunables whether or not there is a command line.
+ *
+ * Recognised keys:
+ *	pages=4k|2m|1g		largest page size the pager may use
+ *	log=err|warn|info	verbosity of the debug output, by default
+ *				ARC_BSP_LOG_LEVEL if defined or else warn
+ *	log.<subsystem>=err|warn|info	verbosity of one of core, boot, mm,
+ *				arch, elf or acpi, overriding log=
+ *	fb=on|off		render to the framebuffer
+ *	fb.scale=<n>		integer scale of the font, 0 picks one by resolution
+ *	splash=on|off		draw a progress bar instead of the log, by
+ *				default on if ARC_BSP_SPLASH is defined
+ *	hhdm=<size>[k|m|g]	extent of the HHDM, 0 maps all memory. It is
+ *				raised to cover all memory the bootstrapper
+ *				reserved or allocated
+ *	kernel.contiguous=on|off	load the kernel into one 2 MiB aligned block
+ *	initramfs.relocate=on|off	move the initramfs into 2 MiB aligned memory
+ *
+ * @param char *cmdline - NUL terminated command line, may be NULL.
+ * @return Number of options which could not be parsed.
+ * */
+int cmdline_parse(char *cmdline);
+
+#endif
@@ -0,0 +1,66 @@
+/**
+ * @file initramfs.h
+ *
+ * @author awewsomegamer <awewsomegamer@gmail.com>
+ *
+ * @LICENSE
+ * Arctan-OS/BSP-GRUB - GRUB bootstrapper for Arctan-OS/Kernel
+ * Copyright (C) 2023-2025 awewsomegamer
+ *
+ * This file is part of Arctan-OS/BSP-GRUB
+ *
+ * Arctan is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 2
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ * @DESCRIPTION
+ * Functions for preparing the initramfs for the kernel.
+*/
+#ifndef ARC_BOOT_INITRAMFS_H
+#define ARC_BOOT_INITRAMFS_H
+
+#include <stdint.h>
+
+/**
+ * Hash a path the way initramfs index entries are keyed.
+ *
+ * 64-bit FNV-1a over the path with any leading "./" or "/" removed.
+ *
+ * @param char *path - The path.
+ * @param uint32_t len - Length of the path in bytes.
+ * @return The hash.
+ * */
+uint64_t initramfs_hash(char *path, uint32_t len);
+
+/**
+ * Build an index of the files in the initramfs.
+ *
+ * Walks the newc CPIO archive once and hands the kernel an array of
+ * ARC_InitramfsIndex entries sorted by path hash, so files can be found
+ * by binary search. Offsets are relative to the base of the initramfs.
+ *
+ * @return Error code (0: success, or no initramfs was given).
+ * */
+int initramfs_index();
+
+/**
+ * Move the initramfs into a 2 MiB aligned block.
+ *
+ * The block is mapped at ARC_INITRAMFS_VADDR if the kernel defines it,
+ * and the memory GRUB placed the module in is marked available.
+ *
+ * @param void *page_tables - The kernel's page tables.
+ * @return Error code (0: success, or no initramfs was given).
+ * */
+int initramfs_relocate(void *page_tables);
+
+#endif
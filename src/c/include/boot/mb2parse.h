@@ -42,4 +42,14 @@
  * */
 int parse_mb2i(uint8_t *mb2i);
 
+/**
+ * Get the first tag of the given type.
+ *
+ * Only valid once parse_mb2i has walked the tags.
+ *
+ * @param uint32_t type - MULTIBOOT_TAG_TYPE_* of the tag.
+ * @return Pointer to the tag, NULL if GRUB did not provide one.
+ * */
+void *mb2_get_tag(uint32_t type);
+
 #endif
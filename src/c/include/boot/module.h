@@ -0,0 +1,92 @@
+/**
+ * @file module.h
+ *
+ * @author awewsomegamer <awewsomegamer@gmail.com>
+ *
+ * @LICENSE
+ * Arctan-OS/BSP-GRUB - GRUB bootstrapper for Arctan-OS/Kernel
+ * Copyright (C) 2023-2025 awewsomegamer
+ *
+ * This file is part of Arctan-OS/BSP-GRUB
+ *
+ * Arctan is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 2
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ * @DESCRIPTION
+ * Table of every module handed to the bootstrapper by GRUB, along with
+ * the functions used to classify them and pre-link driver modules
+ * against the kernel.
+*/
+#ifndef ARC_BOOT_MODULE_H
+#define ARC_BOOT_MODULE_H
+
+#include <stdint.h>
+#include <boot/multiboot2.h>
+#include <elf.h>
+
+// Maximum number of modules that can be placed into the module table
+#define ARC_BSP_MAX_MODULES 32
+
+#define ARC_BSP_MODULE_KERNEL_NAME "arctan-module.kernel.elf"
+#define ARC_BSP_MODULE_INITRAMFS_NAME "arctan-module.initramfs.cpio"
+#define ARC_BSP_MODULE_DRIVER_PREFIX "arctan-module.driver."
+// Optional module listing the expected CRC32C of other modules, one
+// "<module name> <hex digest>" pair per line, lines starting with '#'
+// are ignored
+#define ARC_BSP_MODULE_MANIFEST_NAME "arctan-module.manifest"
+// Symbol looked up in each driver, its virtual address is given to the
+// kernel as the driver's entry point
+#define ARC_BSP_DRIVER_ENTRY_SYMBOL "driver_init"
+
+/**
+ * Classify a MB2 module and place it into the module table.
+ *
+ * The kernel and initramfs modules are also recorded in Arc_KernelMeta.
+ *
+ * @param struct multiboot_tag_module *tag - The module tag.
+ * @return the type of the module (ARC_BOOT_MODULE_*), -1 if the table is full.
+ * */
+int module_register(struct multiboot_tag_module *tag);
+
+/**
+ * Verify modules against the manifest module.
+ *
+ * Does nothing if no manifest was given. Otherwise the CRC32C of every
+ * module listed in the manifest is calculated, recorded in the module
+ * table and compared against the manifest's digest.
+ *
+ * @return zero if there is no manifest or all listed modules match.
+ * */
+int module_verify();
+
+/**
+ * Get the first module of the given type.
+ *
+ * @param uint32_t type - The type of module (ARC_BOOT_MODULE_*).
+ * @return the module's table entry, NULL if there is none.
+ * */
+struct ARC_BootModule *module_find_type(uint32_t type);
+
+/**
+ * Relocate and link all driver modules against the kernel.
+ *
+ * Each driver is placed into the virtual address space directly after
+ * the kernel image. Must be called after the kernel has been loaded.
+ *
+ * @param void *page_tables - The page tables to map the drivers into.
+ * @param struct elf_file *kernel - The validated kernel ELF file.
+ * @return zero on success.
+ * */
+int module_link_drivers(void *page_tables, struct elf_file *kernel);
+
+#endif
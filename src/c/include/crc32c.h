@@ -0,0 +1,51 @@
+/**
+ * @file crc32c.h
+ *
+ * @author awewsomegamer <awewsomegamer@gmail.com>
+ *
+ * @LICENSE
+ * Arctan-OS/BSP-GRUB - GRUB bootstrapper for Arctan-OS/Kernel
+ * Copyright (C) 2023-2025 awewsomegamer
+ *
+ * This file is part of Arctan-OS/BSP-GRUB
+ *
+ * Arctan is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 2
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ * @DESCRIPTION
+ * CRC32C (Castagnoli) checksums used to verify the integrity of modules.
+*/
+#ifndef ARC_CRC32C_H
+#define ARC_CRC32C_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * Prepare CRC32C calculations.
+ *
+ * Builds the slicing-by-8 tables and checks if the processor has a
+ * CRC32 instruction (SSE4.2), which will be used instead if present.
+ * */
+void init_crc32c();
+
+/**
+ * Calculate the CRC32C of a buffer.
+ *
+ * @param const uint8_t *data - The buffer.
+ * @param size_t size - The size of the buffer in bytes.
+ * @return the CRC32C of the buffer.
+ * */
+uint32_t crc32c(const uint8_t *data, size_t size);
+
+#endif
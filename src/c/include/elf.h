@@ -30,6 +30,101 @@
 
 #include <stdint.h>
 
-uint64_t load_elf(void *page_tables, uint8_t *data);
+#define ARC_ELF_TYPE_REL  1
+#define ARC_ELF_TYPE_EXEC 2
+
+// 1: Copy PT_LOAD segments into a contiguous 2 MiB aligned block
+//    instead of mapping sections in place
+#define ARC_ELF_LOAD_CONTIGUOUS 0
+
+/**
+ * Description of an ELF file which has passed elf_validate.
+ *
+ * Everything the loader needs from the headers is located once during
+ * validation, every pointer is known to lie within the file.
+ * */
+struct elf_file {
+	uint8_t *data;
+	uint64_t size;
+	struct Elf64_Ehdr *header;
+	struct Elf64_Phdr *phdrs;
+	struct Elf64_Shdr *shdrs;
+	uint32_t phnum;
+	uint32_t shnum;
+	// First SHT_SYMTAB and its string table
+	struct Elf64_Shdr *symtab;
+	struct Elf64_Sym *symbols;
+	uint32_t symbol_count;
+	char *strtab;
+	uint64_t strtab_size;
+	// PT_TLS segment, NULL if there is none
+	struct Elf64_Phdr *tls;
+	// Virtual span of the PT_LOAD segments
+	uint64_t load_base;
+	uint64_t load_end;
+	// Highest virtual address of the allocated sections
+	uint64_t section_end;
+	// Addresses assigned to the sections of a loaded relocatable file,
+	// NULL until it is loaded, the section headers are left untouched
+	uint64_t *section_addrs;
+};
+
+/**
+ * Validate an ELF file and describe it.
+ *
+ * Checks the header, the program and section header tables and the
+ * bounds of every segment, section and symbol table against the size of
+ * the file. Nothing is allocated or copied.
+ *
+ * @param struct elf_file *file - The description to fill out.
+ * @param uint8_t *data - Pointer to the ELF file.
+ * @param uint64_t size - Size of the ELF file in bytes.
+ * @param uint32_t type - Expected type of the file (ARC_ELF_TYPE_*).
+ * @return zero if the file is valid.
+ * */
+int elf_validate(struct elf_file *file, uint8_t *data, uint64_t size, uint32_t type);
+
+/**
+ * Load an executable ELF file.
+ *
+ * @param void *page_tables - The page tables to map the image into.
+ * @param struct elf_file *file - The validated ELF file.
+ * @param uint32_t flags - ARC_ELF_LOAD_* flags.
+ * @return the entry point of the executable.
+ * */
+uint64_t load_elf(void *page_tables, struct elf_file *file, uint32_t flags);
+
+/**
+ * Load a relocatable (ET_REL) ELF file.
+ *
+ * Allocated sections are copied into freshly allocated memory which is
+ * mapped at vaddr, relocations are applied and undefined symbols are
+ * resolved against the kernel's symbol table. The file itself is not
+ * modified. Files with SHT_REL relocations are rejected.
+ *
+ * @param void *page_tables - The page tables to map the image into.
+ * @param struct elf_file *file - The validated relocatable ELF file.
+ * @param struct elf_file *kernel - The validated kernel ELF file.
+ * @param uint64_t vaddr - Virtual address to load the image at.
+ * @param uint64_t *phys - Set to the physical base of the loaded image.
+ * @return the size of the loaded image in bytes, 0 on failure.
+ * */
+uint64_t load_elf_relocatable(void *page_tables, struct elf_file *file, struct elf_file *kernel, uint64_t vaddr, uint64_t *phys);
+
+/**
+ * Look up a defined, non-local symbol in an ELF file's symbol table.
+ *
+ * @param struct elf_file *file - The validated ELF file.
+ * @param char *name - Name of the symbol.
+ * @param uint64_t *value - Set to the value of the symbol.
+ * @return zero if the symbol was found.
+ * */
+int elf_lookup_symbol(struct elf_file *file, char *name, uint64_t *value);
+
+/**
+ * Get the highest virtual address occupied by the allocated sections
+ * of an ELF file.
+ * */
+uint64_t elf_get_end(struct elf_file *file);
 
 #endif
@@ -37,6 +37,9 @@ extern uint64_t pt_root;
 
 extern struct ARC_KernelMeta Arc_KernelMeta;
 extern struct ARC_BootMeta Arc_BootMeta;
+extern struct ARC_BootTunables Arc_BootTunables;
+// Indexed by ARC_BOOT_LOG_*, the ARC_DEBUG_SUBSYS_* logging at that level
+extern uint32_t Arc_BootLogMask[];
 
 extern uint8_t __BOOTSTRAP_START__;
 extern uint8_t __BOOTSTRAP_END__;
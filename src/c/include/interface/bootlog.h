@@ -0,0 +1,53 @@
+/**
+ * @file bootlog.h
+ *
+ * @author awewsomegamer <awewsomegamer@gmail.com>
+ *
+ * @LICENSE
+ * Arctan-OS/BSP-GRUB - GRUB bootstrapper for Arctan-OS/Kernel
+ * Copyright (C) 2023-2025 awewsomegamer
+ *
+ * This file is part of Arctan-OS/BSP-GRUB
+ *
+ * Arctan is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 2
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ * @DESCRIPTION
+ * Ring buffer of everything printed while bootstrapping, rendered to the
+ * serial port and framebuffer in batches.
+*/
+#ifndef ARC_INTERFACE_BOOTLOG_H
+#define ARC_INTERFACE_BOOTLOG_H
+
+#include <stdint.h>
+
+/**
+ * Append a character to the boot log.
+ *
+ * The character is recorded with the current terminal color and is only
+ * rendered by the next bootlog_flush, which happens by itself once the
+ * ring is full.
+ *
+ * @param char c - The character.
+ * */
+void bootlog_putc(char c);
+
+/**
+ * Render everything appended since the last flush.
+ *
+ * Called at the boundaries between phases of bootstrapping, and on any
+ * error so nothing is lost before a hang.
+ * */
+void bootlog_flush();
+
+#endif
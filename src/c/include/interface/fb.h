@@ -0,0 +1,73 @@
+/**
+ * @file fb.h
+ *
+ * @author awewsomegamer <awewsomegamer@gmail.com>
+ *
+ * @LICENSE
+ * Arctan-OS/BSP-GRUB - GRUB bootstrapper for Arctan-OS/Kernel
+ * Copyright (C) 2023-2025 awewsomegamer
+ *
+ * This file is part of Arctan-OS/BSP-GRUB
+ *
+ * Arctan is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 2
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ * @DESCRIPTION
+ * Pitch-correct drawing primitives for the linear framebuffer.
+*/
+#ifndef ARC_INTERFACE_FB_H
+#define ARC_INTERFACE_FB_H
+
+#include <stdint.h>
+
+/**
+ * Set the framebuffer drawn to.
+ *
+ * @param void *base - Address of the first pixel, must be reachable by the
+ * bootstrapper.
+ * @param int w - Width in pixels.
+ * @param int h - Height in pixels.
+ * @param int pitch - Bytes from one scanline to the next.
+ * @param int bpp - Bits per pixel, one of 16, 24 or 32.
+ * @return zero on success, -1 if the framebuffer cannot be drawn to.
+ * */
+int fb_init(void *base, int w, int h, int pitch, int bpp);
+
+/**
+ * Get the address of a pixel.
+ *
+ * Pixels to the right are found by adding multiples of fb_bytes, and the
+ * pixel below by adding fb_pitch.
+ *
+ * @param int x - Column of the pixel.
+ * @param int y - Scanline of the pixel.
+ * @return the address of the pixel, NULL if there is no framebuffer.
+ * */
+uint8_t *fb_pixel(int x, int y);
+int fb_pitch();
+int fb_bytes();
+
+/**
+ * Fill a rectangle with one color.
+ *
+ * The rectangle is clipped to the framebuffer.
+ *
+ * @param int x - Left edge.
+ * @param int y - Top edge.
+ * @param int w - Width in pixels.
+ * @param int h - Height in pixels.
+ * @param uint32_t color - Color in the framebuffer's pixel format.
+ * */
+void fb_fill_rect(int x, int y, int w, int h, uint32_t color);
+
+#endif
@@ -0,0 +1,104 @@
+/**
+ * @file logtoken.h
+ *
+ * @author awewsomegamer <awewsomegamer@gmail.com>
+ *
+ * @LICENSE
+ * Arctan-OS/BSP-GRUB - GRUB bootstrapper for Arctan-OS/Kernel
+ * Copyright (C) 2023-2025 awewsomegamer
+ *
+ * This file is part of Arctan-OS/BSP-GRUB
+ *
+ * Arctan is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 2
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ * @DESCRIPTION
+ * Tokenised logging, enabled by defining ARC_DEBUG_TOKENS.
+ * 
+ * Instead of formatting a message, each ARC_DEBUG call site places its
+ * format string in the .arc_logtab section, which is not loaded, and logs
+ * a record of the string's offset in that section followed by the raw
+ * arguments. tools/logdecode rebuilds the text from the records and the
+ * section in bootstrap.elf.
+*/
+#ifndef ARC_INTERFACE_LOGTOKEN_H
+#define ARC_INTERFACE_LOGTOKEN_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Record layout, all values little endian:
+ *	u8  ARC_LOG_TOKEN_MARK
+ *	u32 offset of the format string in .arc_logtab
+ *	u8  number of arguments
+ * then for each argument a u8 kind followed by:
+ *	kind 0-8: that many low bytes of the argument, the rest are 0
+ *	kind ARC_LOG_TOKEN_STR: u8 length and the characters of the string
+ * */
+#define ARC_LOG_TOKEN_MARK 0xFF
+#define ARC_LOG_TOKEN_STR 0x80
+#define ARC_LOG_TOKEN_STR_MAX 0x80
+
+#define ARC_LOG_CAT_(a, b) a##b
+#define ARC_LOG_CAT(a, b) ARC_LOG_CAT_(a, b)
+
+#define ARC_LOG_NARGS_(_0, _1, _2, _3, _4, _5, _6, _7, _8, _9, _10, _11, _12, N, ...) N
+#define ARC_LOG_NARGS(...) ARC_LOG_NARGS_(_, ##__VA_ARGS__, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0)
+
+// Arrays decay and integers are promoted by the + 0, only char pointers
+// are sent as strings
+#define ARC_LOG_ARG(__arg__) {								\
+		__typeof__((__arg__) + 0) _arc_log_arg = (__arg__);			\
+		log_token_arg(&_arc_log_arg, sizeof(_arc_log_arg),			\
+			      _Generic(_arc_log_arg, char *: 1, const char *: 1, default: 0)); \
+	}
+
+#define ARC_LOG_ARGS_0()
+#define ARC_LOG_ARGS_1(a) ARC_LOG_ARG(a)
+#define ARC_LOG_ARGS_2(a, ...) ARC_LOG_ARG(a) ARC_LOG_ARGS_1(__VA_ARGS__)
+#define ARC_LOG_ARGS_3(a, ...) ARC_LOG_ARG(a) ARC_LOG_ARGS_2(__VA_ARGS__)
+#define ARC_LOG_ARGS_4(a, ...) ARC_LOG_ARG(a) ARC_LOG_ARGS_3(__VA_ARGS__)
+#define ARC_LOG_ARGS_5(a, ...) ARC_LOG_ARG(a) ARC_LOG_ARGS_4(__VA_ARGS__)
+#define ARC_LOG_ARGS_6(a, ...) ARC_LOG_ARG(a) ARC_LOG_ARGS_5(__VA_ARGS__)
+#define ARC_LOG_ARGS_7(a, ...) ARC_LOG_ARG(a) ARC_LOG_ARGS_6(__VA_ARGS__)
+#define ARC_LOG_ARGS_8(a, ...) ARC_LOG_ARG(a) ARC_LOG_ARGS_7(__VA_ARGS__)
+#define ARC_LOG_ARGS_9(a, ...) ARC_LOG_ARG(a) ARC_LOG_ARGS_8(__VA_ARGS__)
+#define ARC_LOG_ARGS_10(a, ...) ARC_LOG_ARG(a) ARC_LOG_ARGS_9(__VA_ARGS__)
+#define ARC_LOG_ARGS_11(a, ...) ARC_LOG_ARG(a) ARC_LOG_ARGS_10(__VA_ARGS__)
+#define ARC_LOG_ARGS_12(a, ...) ARC_LOG_ARG(a) ARC_LOG_ARGS_11(__VA_ARGS__)
+
+#define ARC_LOG_TOKEN(__fmt__, ...) {							\
+		static const char _arc_log_fmt[] __attribute__((section(".arc_logtab"), used)) = __fmt__; \
+		log_token_begin((uint32_t)(uintptr_t)_arc_log_fmt, ARC_LOG_NARGS(__VA_ARGS__)); \
+		ARC_LOG_CAT(ARC_LOG_ARGS_, ARC_LOG_NARGS(__VA_ARGS__))(__VA_ARGS__)	\
+	}
+
+/**
+ * Start a record.
+ *
+ * @param uint32_t id - Offset of the format string in .arc_logtab.
+ * @param int nargs - Number of arguments which follow.
+ * */
+void log_token_begin(uint32_t id, int nargs);
+
+/**
+ * Append an argument to the current record.
+ *
+ * @param const void *value - The argument.
+ * @param size_t size - Size of the argument in bytes, at most 8.
+ * @param int string - 1: the argument is a char * whose characters are sent.
+ * */
+void log_token_arg(const void *value, size_t size, int string);
+
+#endif
@@ -29,26 +29,47 @@
 
 #include <stdint.h>
 
-typedef struct {
-	uint32_t data : 24;
-}__attribute__((packed)) uint24_s;
-
-#define ARC_FB_DRAW(__addr, __x, __y, __bpp, __color)			\
-	switch (__bpp) {						\
-		case 32:						\
-			*((uint32_t *)__addr + __x + __y) = __color;	\
-			break;						\
-		case 24:						\
-			((uint24_s *)__addr + __x + __y)->data = __color; \
-			break;						\
-		case 16:						\
-			*((uint16_t *)__addr + __x + __y) = __color;	\
-			break;						\
-	}
-
-void set_term(void *address, int w, int h, int bpp);
-void term_putchar(char c);
+/**
+ * Set the framebuffer the terminal draws to.
+ *
+ * The font is scaled by bsp.fb.scale or, by default, to suit the
+ * resolution. Framebuffers which are above 4 GiB or not 16, 24 or 32 bpp
+ * are only described to the kernel.
+ *
+ * @param uint64_t address - Physical address of the framebuffer.
+ * @param int w - Width in pixels.
+ * @param int h - Height in pixels.
+ * @param int pitch - Bytes from one scanline to the next.
+ * @param int bpp - Bits per pixel.
+ * */
+void set_term(uint64_t address, int w, int h, int pitch, int bpp);
+/**
+ * Output a character without drawing it to the framebuffer.
+ *
+ * The framebuffer is brought up to date by the next term_flush.
+ * */
+void term_emit(char c);
+/**
+ * Draw the rows of the text shadow which changed since the last flush.
+ * */
+void term_flush();
+/**
+ * Advance the progress bar shown in splash mode.
+ *
+ * In splash mode (bsp.splash) text only goes to the serial port and the
+ * boot log, the framebuffer shows nothing but this bar. Outside of
+ * splash mode this does nothing.
+ *
+ * @param int done - Steps completed so far.
+ * @param int total - Number of steps to a full bar.
+ * */
+void term_progress(int done, int total);
 void term_set_fg(uint32_t color);
+uint32_t term_get_fg();
 void init_uart();
+/**
+ * Write a character to the serial port only.
+ * */
+void uart_putc(char c);
 
 #endif
@@ -0,0 +1,124 @@
+/**
+ * @file mmap.h
+ *
+ * @author awewsomegamer <awewsomegamer@gmail.com>
+ *
+ * @LICENSE
+ * Arctan-OS/BSP-GRUB - GRUB bootstrapper for Arctan-OS/Kernel
+ * Copyright (C) 2023-2025 awewsomegamer
+ *
+ * This file is part of Arctan-OS/BSP-GRUB
+ *
+ * Arctan is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 2
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ * @DESCRIPTION
+ * Functions for building the ARC_MMap out of the (possibly overlapping)
+ * ranges reported by firmware.
+*/
+#ifndef ARC_MM_MMAP_H
+#define ARC_MM_MMAP_H
+
+#include <arctan.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Entries reserved on top of the normalised map for later splits (i.e.
+// watermark allocations and type changes)
+#define ARC_MMAP_HEADROOM 64
+
+/**
+ * Number of entries a map built from the given ranges needs.
+ *
+ * @param int count - Number of firmware ranges.
+ * @param int overlay_count - Number of overlays.
+ * @return Capacity of the map, including ARC_MMAP_HEADROOM.
+ * */
+int mmap_capacity(int count, int overlay_count);
+
+/**
+ * Size of the scratch memory mmap_normalize needs.
+ *
+ * @param int count - Number of firmware ranges.
+ * @param int overlay_count - Number of overlays.
+ * @return Size in bytes.
+ * */
+size_t mmap_scratch_size(int count, int overlay_count);
+
+/**
+ * Sort and normalise a memory map.
+ *
+ * Overlapping ranges are resolved by type precedence (the lower
+ * ARC_MEMORY_* value wins) and adjacent ranges of the same type are
+ * coalesced. Overlays only take effect where the map itself has a range,
+ * they never add memory the firmware did not report.
+ *
+ * @param struct ARC_MMap *map - The map, rewritten in place.
+ * @param int count - Number of entries in the map.
+ * @param int capacity - Most entries map can hold.
+ * @param struct ARC_MMap *overlays - Reservations to lay over the map, may be NULL.
+ * @param int overlay_count - Number of overlays.
+ * @param void *scratch - At least mmap_scratch_size(count, overlay_count) bytes.
+ * @return The new number of entries in the map, -1 on failure.
+ * */
+int mmap_normalize(struct ARC_MMap *map, int count, int capacity, struct ARC_MMap *overlays, int overlay_count, void *scratch);
+
+/**
+ * Make the given map the ARC_MMap handed to the kernel.
+ *
+ * @param struct ARC_MMap *map - Normalised map.
+ * @param int len - Number of entries in the map.
+ * @param int capacity - Most entries map can hold.
+ * */
+void mmap_use(struct ARC_MMap *map, int len, int capacity);
+
+/**
+ * Change the type of a range in the ARC_MMap.
+ *
+ * Unlike overlays the new type is applied regardless of precedence,
+ * entries are split where needed and neighbours of the same type are
+ * coalesced. Parts of the range the map does not cover are ignored.
+ *
+ * @param uint64_t base - Base of the range.
+ * @param uint64_t len - Length of the range.
+ * @param uint32_t type - The new ARC_MEMORY_* type.
+ * @return Error code (0: success, -1: the map is full).
+ * */
+int mmap_set_type(uint64_t base, uint64_t len, uint32_t type);
+
+/**
+ * Shrink the ARC_MMap's storage to its live length.
+ *
+ * Returns the unused tail of the storage to the map as available memory.
+ * Nothing may split the map after this.
+ *
+ * @return Error code (0: success).
+ * */
+int mmap_compact();
+
+/**
+ * Check the invariants of a normalised map.
+ *
+ * Entries must be non-empty, sorted, non-overlapping and coalesced, and
+ * no part of a reservation may be left available. Every violation is
+ * reported.
+ *
+ * @param struct ARC_MMap *map - The map.
+ * @param int count - Number of entries in the map.
+ * @param struct ARC_MMap *reservations - Reservations laid over the map, may be NULL.
+ * @param int reservation_count - Number of reservations.
+ * @return Number of violations found.
+ * */
+int mmap_check(struct ARC_MMap *map, int count, struct ARC_MMap *reservations, int reservation_count);
+
+#endif
@@ -33,5 +33,6 @@
 
 int watermark_update_mmap();
 void *alloc(size_t size);
+void *alloc_aligned(size_t size, size_t align);
 
 #endif
\ No newline at end of file
@@ -33,6 +33,8 @@
 
 #include <interface/printf.h>
 #include <interface/terminal.h>
+#include <interface/bootlog.h>
+#include <interface/logtoken.h>
 
 #define ARC_DEBUG_STRINGIFY(val) #val
 #define ARC_DEBUG_TOSTRING(val) ARC_DEBUG_STRINGIFY(val)
@@ -42,21 +44,45 @@
 #define ARC_DEBUG_WARN_STR "[WARNING]"
 #define ARC_DEBUG_ERR_STR  "[ERROR]"
 
+#ifdef ARC_DEBUG_TOKENS
+// Only the call site and arguments are logged, see interface/logtoken.h
+#define ARC_DEBUG_PRINT(__level_str__, ...) ARC_LOG_TOKEN(__level_str__ ARC_DEBUG_NAME_STR ARC_DEBUG_NAME_SEP_STR __VA_ARGS__)
+#else
+#define ARC_DEBUG_PRINT(__level_str__, ...) printf(__level_str__ ARC_DEBUG_NAME_STR ARC_DEBUG_NAME_SEP_STR __VA_ARGS__);
+#endif
+
+// Subsystems whose messages can be filtered separately (bsp.log.<name>=),
+// a file picks one by defining ARC_DEBUG_SUBSYS before any includes
+#define ARC_DEBUG_SUBSYS_CORE (1 << 0)
+#define ARC_DEBUG_SUBSYS_BOOT (1 << 1)
+#define ARC_DEBUG_SUBSYS_MM   (1 << 2)
+#define ARC_DEBUG_SUBSYS_ARCH (1 << 3)
+#define ARC_DEBUG_SUBSYS_ELF  (1 << 4)
+#define ARC_DEBUG_SUBSYS_ACPI (1 << 5)
+#define ARC_DEBUG_SUBSYS_COUNT 6
+
+#ifndef ARC_DEBUG_SUBSYS
+#define ARC_DEBUG_SUBSYS ARC_DEBUG_SUBSYS_CORE
+#endif
+
 #define ARC_DEBUG(__level__, ...) ARC_DEBUG_##__level__(__VA_ARGS__)
-#define ARC_DEBUG_ERR(...)  term_set_fg(0x00FF0000); printf(ARC_DEBUG_ERR_STR ARC_DEBUG_NAME_STR ARC_DEBUG_NAME_SEP_STR __VA_ARGS__);
+// Errors are rendered straight away, the boot may not get much further
+#define ARC_DEBUG_ERR(...)  term_set_fg(0x00FF0000); ARC_DEBUG_PRINT(ARC_DEBUG_ERR_STR, __VA_ARGS__) bootlog_flush();
 
 #ifdef ARC_DEBUG_ENABLE
 #define ARC_DEBUG_INFO_STR "[INFO]"
 #define ARC_DEBUG_WARN_STR "[WARNING]"
-#define ARC_DEBUG_INFO(...) term_set_fg(0xFFFFFFFF); printf(ARC_DEBUG_INFO_STR ARC_DEBUG_NAME_STR ARC_DEBUG_NAME_SEP_STR __VA_ARGS__);
-#define ARC_DEBUG_WARN(...) term_set_fg(0x00FFFF00); printf(ARC_DEBUG_WARN_STR ARC_DEBUG_NAME_STR ARC_DEBUG_NAME_SEP_STR __VA_ARGS__);
+// Verbosity is set at runtime by bsp.log= and bsp.log.<subsystem>= (see
+// boot/cmdline.h), which leave one mask of enabled subsystems per level
+#define ARC_DEBUG_INFO(...) if (Arc_BootLogMask[ARC_BOOT_LOG_INFO] & ARC_DEBUG_SUBSYS) { term_set_fg(0xFFFFFFFF); ARC_DEBUG_PRINT(ARC_DEBUG_INFO_STR, __VA_ARGS__) }
+#define ARC_DEBUG_WARN(...) if (Arc_BootLogMask[ARC_BOOT_LOG_WARN] & ARC_DEBUG_SUBSYS) { term_set_fg(0x00FFFF00); ARC_DEBUG_PRINT(ARC_DEBUG_WARN_STR, __VA_ARGS__) }
 #else
 #define ARC_DEBUG_INFO(...) ;
 #define ARC_DEBUG_WARN(...) ;
 #endif // ARC_DEBUG_ENABLE
 
 #if defined(ARC_TARGET_ARCH_X86_64) || defined(ARC_TARGET_ARCH_X86)
-#define ARC_HANG __asm__("1: hlt; jmp 1b");
+#define ARC_HANG bootlog_flush(); __asm__("1: hlt; jmp 1b");
 #endif
 
 
@@ -80,8 +106,21 @@
 #define MASKED_WRITE(__to, __value, __shift, __mask) __to = (((__to) & ~((__mask) << (__shift))) | (((__value) & (__mask)) << (__shift)));
 
 int strcmp(char *a, char *b);
+int strncmp(char *a, char *b, size_t n);
 int memcpy(void *a, void *b, size_t size);
 int nmemcpy(void *a, void *b, size_t size);
 void memset(void *mem, uint8_t value, size_t size);
 
+/**
+ * In-place heapsort.
+ *
+ * Not stable, uses no memory beyond the array itself.
+ *
+ * @param void *base - The array to sort.
+ * @param size_t count - Number of elements in the array.
+ * @param size_t size - Size of a single element in bytes.
+ * @param int (*cmp)(const void *, const void *) - Returns <0, 0, >0 when the first element is less than, equal to, or greater than the second.
+ * */
+void hsort(void *base, size_t count, size_t size, int (*cmp)(const void *, const void *));
+
 #endif
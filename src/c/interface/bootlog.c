@@ -0,0 +1,78 @@
+/**
+ * @file bootlog.c
+ *
+ * @author awewsomegamer <awewsomegamer@gmail.com>
+ *
+ * @LICENSE
+ * Arctan-OS/BSP-GRUB - GRUB bootstrapper for Arctan-OS/Kernel
+ * Copyright (C) 2023-2025 awewsomegamer
+ *
+ * This file is part of Arctan-OS/BSP-GRUB
+ *
+ * Arctan is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 2
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ * @DESCRIPTION
+ * Ring buffer of everything printed while bootstrapping.
+ * 
+ * Output is only written to the serial port and framebuffer when the log
+ * is flushed, so loops which print do not wait on either device. The ring
+ * is handed to the kernel through Arc_KernelMeta.bootlog so it can replay
+ * the bootstrap log into its own console.
+*/
+#include <global.h>
+#include <interface/bootlog.h>
+#include <interface/terminal.h>
+
+#ifndef ARC_BOOTLOG_SIZE
+// Number of characters kept, must be a power of two
+#define ARC_BOOTLOG_SIZE 0x4000
+#endif
+
+// Each entry is the character in the low byte and its color above it
+static uint32_t bootlog[ARC_BOOTLOG_SIZE] = { 0 };
+// Number of characters ever appended and ever rendered
+static uint32_t head = 0;
+static uint32_t rendered = 0;
+
+void bootlog_putc(char c) {
+	if (head - rendered >= ARC_BOOTLOG_SIZE) {
+		bootlog_flush();
+	}
+
+	bootlog[head & (ARC_BOOTLOG_SIZE - 1)] = ((term_get_fg() & 0xFFFFFF) << 8) | (uint8_t)c;
+	head++;
+}
+
+void bootlog_flush() {
+	uint32_t fg = term_get_fg();
+
+	for (; rendered != head; rendered++) {
+		uint32_t entry = bootlog[rendered & (ARC_BOOTLOG_SIZE - 1)];
+
+#ifdef ARC_DEBUG_TOKENS
+		// Records are binary, only the serial port can take them
+		uart_putc(entry & 0xFF);
+#else
+		term_set_fg(entry >> 8);
+		term_emit(entry & 0xFF);
+#endif
+	}
+
+	term_set_fg(fg);
+	term_flush();
+
+	Arc_KernelMeta.bootlog.base = (uintptr_t)bootlog;
+	Arc_KernelMeta.bootlog.len = ARC_BOOTLOG_SIZE;
+	Arc_KernelMeta.bootlog.head = head;
+}
@@ -0,0 +1,136 @@
+/**
+ * @file fb.c
+ *
+ * @author awewsomegamer <awewsomegamer@gmail.com>
+ *
+ * @LICENSE
+ * Arctan-OS/BSP-GRUB - GRUB bootstrapper for Arctan-OS/Kernel
+ * Copyright (C) 2023-2025 awewsomegamer
+ *
+ * This file is part of Arctan-OS/BSP-GRUB
+ *
+ * Arctan is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 2
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ * @DESCRIPTION
+ * Pitch-correct drawing primitives for the linear framebuffer.
+ * 
+ * Every primitive works out the address of the first pixel of a row once
+ * and steps to the next row by the pitch, so padded scanlines are handled
+ * and no per-pixel multiplication is done.
+*/
+#include <global.h>
+#include <interface/fb.h>
+#include <util.h>
+
+static uint8_t *fb_base = NULL;
+static int fb_width = 0;
+static int fb_height = 0;
+static int fb_row_pitch = 0;
+static int fb_pixel_bytes = 0;
+
+int fb_init(void *base, int w, int h, int pitch, int bpp) {
+	fb_base = NULL;
+
+	if (base == NULL || (bpp != 16 && bpp != 24 && bpp != 32) || pitch < w * (bpp / 8)) {
+		return -1;
+	}
+
+	fb_base = base;
+	fb_width = w;
+	fb_height = h;
+	fb_row_pitch = pitch;
+	fb_pixel_bytes = bpp / 8;
+
+	return 0;
+}
+
+uint8_t *fb_pixel(int x, int y) {
+	if (fb_base == NULL) {
+		return NULL;
+	}
+
+	return fb_base + y * fb_row_pitch + x * fb_pixel_bytes;
+}
+
+int fb_pitch() {
+	return fb_row_pitch;
+}
+
+int fb_bytes() {
+	return fb_pixel_bytes;
+}
+
+static void fb_fill_span(uint8_t *span, int count, uint32_t color) {
+	switch (fb_pixel_bytes) {
+		case 4: {
+			for (int i = 0; i < count; i++) {
+				((uint32_t *)span)[i] = color;
+			}
+
+			break;
+		}
+
+		case 3: {
+			for (int i = 0; i < count; i++, span += 3) {
+				span[0] = color;
+				span[1] = color >> 8;
+				span[2] = color >> 16;
+			}
+
+			break;
+		}
+
+		case 2: {
+			for (int i = 0; i < count; i++) {
+				((uint16_t *)span)[i] = color;
+			}
+
+			break;
+		}
+	}
+}
+
+/**
+ * Clip a rectangle to the framebuffer.
+ *
+ * @return zero if nothing of the rectangle is left.
+ * */
+static int fb_clip(int *x, int *y, int *w, int *h) {
+	if (*x < 0) {
+		*w += *x;
+		*x = 0;
+	}
+
+	if (*y < 0) {
+		*h += *y;
+		*y = 0;
+	}
+
+	*w = min(*w, fb_width - *x);
+	*h = min(*h, fb_height - *y);
+
+	return fb_base != NULL && *w > 0 && *h > 0;
+}
+
+void fb_fill_rect(int x, int y, int w, int h, uint32_t color) {
+	if (!fb_clip(&x, &y, &w, &h)) {
+		return;
+	}
+
+	uint8_t *row = fb_pixel(x, y);
+
+	for (int i = 0; i < h; i++, row += fb_row_pitch) {
+		fb_fill_span(row, w, color);
+	}
+}
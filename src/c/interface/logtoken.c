@@ -0,0 +1,76 @@
+/**
+ * @file logtoken.c
+ *
+ * @author awewsomegamer <awewsomegamer@gmail.com>
+ *
+ * @LICENSE
+ * Arctan-OS/BSP-GRUB - GRUB bootstrapper for Arctan-OS/Kernel
+ * Copyright (C) 2023-2025 awewsomegamer
+ *
+ * This file is part of Arctan-OS/BSP-GRUB
+ *
+ * Arctan is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 2
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ * @DESCRIPTION
+ * Tokenised logging records, see interface/logtoken.h.
+*/
+#include <global.h>
+#include <interface/bootlog.h>
+#include <interface/logtoken.h>
+#include <util.h>
+
+void log_token_begin(uint32_t id, int nargs) {
+	bootlog_putc(ARC_LOG_TOKEN_MARK);
+
+	for (int i = 0; i < 4; i++) {
+		bootlog_putc((id >> (i * 8)) & 0xFF);
+	}
+
+	bootlog_putc(nargs);
+}
+
+void log_token_arg(const void *value, size_t size, int string) {
+	if (string) {
+		const char *str = *(const char **)value;
+		int len = 0;
+
+		// Precision limited strings (%.4s) need not be terminated
+		while (str != NULL && len < ARC_LOG_TOKEN_STR_MAX && str[len] != 0) {
+			len++;
+		}
+
+		bootlog_putc(ARC_LOG_TOKEN_STR);
+		bootlog_putc(len);
+
+		for (int i = 0; i < len; i++) {
+			bootlog_putc(str[i]);
+		}
+
+		return;
+	}
+
+	const uint8_t *bytes = (const uint8_t *)value;
+	size = min(size, sizeof(uint64_t));
+
+	// The high zero bytes are implied
+	while (size > 0 && bytes[size - 1] == 0) {
+		size--;
+	}
+
+	bootlog_putc(size);
+
+	for (size_t i = 0; i < size; i++) {
+		bootlog_putc(bytes[i]);
+	}
+}
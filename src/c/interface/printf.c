@@ -29,10 +29,10 @@
 #include <global.h>
 
 #include <interface/printf.h>
-#include <interface/terminal.h>
+#include <interface/bootlog.h>
 
 void putchar_(char c) {
-        term_putchar(c);
+        bootlog_putc(c);
 }
 
 /**
@@ -26,6 +26,9 @@
 */
 #include <arch/io/port.h>
 #include <global.h>
+#include <interface/fb.h>
+#include <inttypes.h>
+#include <mm/watermark.h>
 #include <util.h>
 
 // This is not at all cursed, don't worry about it
@@ -34,84 +37,330 @@ const uint8_t character_rom[] = { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00
 static int term_x = 0;
 static int term_y = 0;
 static uint32_t fg = 0xFFFFFF;
-#include <inttypes.h>
 
-void set_term(void *address, int w, int h, int bpp) {
-        Arc_BootMeta.term.base = (uint32_t)address;
+// Most text rows tracked, enough for a 4K panel at the smallest scale
+#define ARC_TERM_MAX_ROWS 270
+
+// Text-cell shadow of the screen, a ring of rows starting at term_top.
+// Each cell is the character in the low byte and its color above it.
+// Allocated by set_term to fit the screen's text grid
+static uint32_t *cells = NULL;
+// Used length of each shadow row (indexed by ring row)
+static uint16_t row_len[ARC_TERM_MAX_ROWS] = { 0 };
+// Length of what is currently drawn on each screen row
+static uint16_t drawn_len[ARC_TERM_MAX_ROWS] = { 0 };
+// Screen rows which differ from the shadow
+static uint8_t dirty[ARC_TERM_MAX_ROWS] = { 0 };
+static int term_cols = 0;
+static int term_rows = 0;
+static int term_top = 0;
+
+// Depth of the UART's transmit FIFO, and how many more bytes can be
+// written before it has to be polled again
+static int uart_fifo = 1;
+static int uart_room = 0;
+
+// Largest integer scale of the 8x8 font
+#define ARC_TERM_MAX_SCALE 4
+
+// Framebuffer as seen by the bootstrapper, NULL if it cannot be drawn to
+static uint8_t *term_fb = NULL;
+static int term_bytes = 0;
+static int term_scale = 1;
+// Size of a (scaled) glyph and the dwords each of its scanlines take
+static int term_cell = 8;
+static int term_row_dwords = 0;
+
+// In splash mode no text is drawn, only a progress bar
+static int term_splash = 0;
+static int term_width = 0;
+static int term_height = 0;
+// Pixels of the progress bar filled in so far, -1 before it is drawn
+static int splash_filled = -1;
+
+#define ARC_SPLASH_TRACK 0x404040
+#define ARC_SPLASH_BAR 0xFFFFFF
+
+// For each possible glyph row (byte), the dwords making up that row of
+// 8 pixels, already scaled horizontally, at the current bpp with set
+// pixels all 1s and clear pixels 0s
+static uint32_t glyph_masks[256 * 8 * ARC_TERM_MAX_SCALE] = { 0 };
+
+static void term_build_masks() {
+        for (int b = 0; b < 256; b++) {
+                // Pixels are stored little endian, so the leftmost one
+                // lands in the lowest bytes
+                uint8_t *lanes = (uint8_t *)&glyph_masks[b * term_row_dwords];
+                int byte = 0;
+
+                for (int j = 0; j < 8; j++) {
+                        uint8_t set = ((b >> (7 - j)) & 1) ? 0xFF : 0;
+
+                        for (int k = 0; k < term_scale * term_bytes; k++) {
+                                lanes[byte++] = set;
+                        }
+                }
+        }
+}
+
+/**
+ * Draw a glyph, writing whole rows of pixels at a time.
+ *
+ * Clear pixels are drawn in black.
+ * */
+static void term_draw_glyph(uint8_t c, uint32_t color, int sx, int sy) {
+        const uint8_t *glyph = &character_rom[c * 8];
+
+        // The foreground color repeated across the dwords of a row, a 24
+        // bpp row repeats every 3 dwords
+        uint32_t pattern[3] = { color, color, color };
+
+        if (term_bytes == 3) {
+                uint32_t c24 = color & 0xFFFFFF;
+                pattern[0] = c24 | (c24 << 24);
+                pattern[1] = (c24 >> 8) | (c24 << 16);
+                pattern[2] = (c24 >> 16) | (c24 << 8);
+        } else if (term_bytes == 2) {
+                pattern[0] = (color & 0xFFFF) * 0x10001;
+                pattern[1] = pattern[0];
+                pattern[2] = pattern[0];
+        }
+
+        uint8_t *line = fb_pixel(sx, sy);
+        int pitch = fb_pitch();
+
+        for (int i = 0; i < 8; i++) {
+                uint32_t *mask = &glyph_masks[glyph[i] * term_row_dwords];
+
+                for (int r = 0; r < term_scale; r++, line += pitch) {
+                        uint32_t *row = (uint32_t *)line;
+
+                        for (int k = 0, p = 0; k < term_row_dwords; k++) {
+                                row[k] = pattern[p] & mask[k];
+                                p = p == 2 ? 0 : p + 1;
+                        }
+                }
+        }
+}
+
+void set_term(uint64_t address, int w, int h, int pitch, int bpp) {
+        Arc_BootMeta.term.base = address;
         Arc_BootMeta.term.width = w;
         Arc_BootMeta.term.height = h;
+        Arc_BootMeta.term.pitch = pitch;
         Arc_BootMeta.term.bpp = bpp;
         Arc_BootMeta.term.char_rom = (uint32_t)&character_rom;
-}
 
-void term_putchar(char c) {
-#ifdef ARC_COM_PORT
-        uint8_t lsr = inb(ARC_COM_PORT + 5);
-        while (MASKED_READ(lsr, 5, 1) == 0) {
-                lsr = inb(ARC_COM_PORT + 5);
+        // Unless set on the command line, scale the font so a 4K screen
+        // has roughly as many columns as a 720p one
+        term_scale = Arc_BootTunables.fb_scale;
+
+        if (term_scale == 0) {
+                term_scale = max(min(w / 1280, h / 720), 1);
         }
 
-        outb(ARC_COM_PORT, c);
-#endif
+        term_scale = min(term_scale, ARC_TERM_MAX_SCALE);
+        Arc_BootMeta.term.scale = term_scale;
 
-        if (Arc_BootMeta.term.base == 0) {
+        term_fb = NULL;
+
+        // The bootstrapper is unpaged, a framebuffer above 4 GiB is left to
+        // the kernel
+        if (address + (uint64_t)pitch * h > 0x100000000
+            || fb_init((void *)(uintptr_t)address, w, h, pitch, bpp) != 0) {
+                ARC_DEBUG(WARN, "Framebuffer 0x%"PRIx64" (%d bpp) cannot be drawn to\n", address, bpp);
                 return;
         }
 
-        if (term_x >= Arc_BootMeta.term.width / 8) {
+        term_bytes = fb_bytes();
+        term_width = w;
+        term_height = h;
+        term_splash = Arc_BootTunables.splash;
+        splash_filled = -1;
+        term_cell = 8 * term_scale;
+        term_row_dwords = 2 * term_scale * term_bytes;
+
+        term_cols = max(w / term_cell, 1);
+        term_rows = min(max(h / term_cell - 5, 1), ARC_TERM_MAX_ROWS);
+        term_x = 0;
+        term_y = 0;
+        term_top = 0;
+
+        // Splash mode draws no text, so has no use for the shadow
+        if (!term_splash) {
+                size_t size = (size_t)term_cols * term_rows * sizeof(uint32_t);
+
+                cells = alloc(size);
+
+                if (cells == NULL) {
+                        ARC_DEBUG(WARN, "No memory for a %dx%d text shadow, not drawing to the framebuffer\n", term_cols, term_rows);
+                        return;
+                }
+
+                memset(cells, 0, size);
+        }
+
+        term_build_masks();
+
+        term_fb = fb_pixel(0, 0);
+
+        memset(row_len, 0, sizeof(row_len));
+        memset(drawn_len, 0, sizeof(drawn_len));
+        memset(dirty, 0, sizeof(dirty));
+}
+
+static inline uint32_t *term_row(int y) {
+        return &cells[((term_top + y) % term_rows) * term_cols];
+}
+
+/**
+ * Scroll the shadow buffer up by one line.
+ *
+ * Only moves the start of the ring, the framebuffer is brought up to
+ * date by the next term_flush.
+ * */
+static void term_scroll() {
+        int last = term_top;
+
+        term_top = (term_top + 1) % term_rows;
+        memset(&cells[last * term_cols], 0, row_len[last] * sizeof(uint32_t));
+        row_len[last] = 0;
+
+        memset(dirty, 1, term_rows);
+}
+
+static void term_newline() {
+        term_x = 0;
+
+        if (term_y + 1 >= term_rows) {
+                term_scroll();
+        } else {
                 term_y++;
-                term_x = 0;
         }
+}
+
+void term_flush() {
+        if (term_fb == NULL || term_splash) {
+                return;
+        }
+
+        for (int y = 0; y < term_rows; y++) {
+                if (!dirty[y]) {
+                        continue;
+                }
 
-        if (term_y >= Arc_BootMeta.term.height / 8 - 5) {
-                term_y = 0;
-                term_x = 0;
+                uint32_t *row = term_row(y);
+                int len = row_len[(term_top + y) % term_rows];
 
-		memset((void *)Arc_BootMeta.term.base, 0, Arc_BootMeta.term.width * Arc_BootMeta.term.height * (Arc_BootMeta.term.bpp / 8));
+                // Cells past the end of the row are zero, so drawing up
+                // to the old length also clears what was there before
+                for (int x = 0; x < max(len, drawn_len[y]); x++) {
+                        term_draw_glyph(row[x] & 0xFF, row[x] >> 8, x * term_cell, y * term_cell);
+                }
+
+                drawn_len[y] = len;
+                dirty[y] = 0;
         }
+}
 
-        int sx = term_x * 8;
-        int sy = term_y * 8;
+void uart_putc(char c) {
+#ifdef ARC_COM_PORT
+        // THR empty means the whole transmit FIFO is empty, so only wait
+        // once per FIFO's worth of bytes
+        if (uart_room == 0) {
+                uint8_t lsr = inb(ARC_COM_PORT + 5);
+                while (MASKED_READ(lsr, 5, 1) == 0) {
+                        lsr = inb(ARC_COM_PORT + 5);
+                }
+
+                uart_room = uart_fifo;
+        }
+
+        outb(ARC_COM_PORT, c);
+        uart_room--;
+#else
+        (void)c;
+#endif
+}
+
+void term_emit(char c) {
+        uart_putc(c);
+
+        if (term_fb == NULL || term_splash) {
+                return;
+        }
 
         switch (c) {
         case '\n': {
-              term_x = 0;
-              term_y++;
-              break;
+                term_newline();
+                break;
         }
 
         case '\t': {
-            term_x += 8;
-            break;
+                term_x += 8;
+
+                if (term_x >= term_cols) {
+                        term_newline();
+                }
+
+                break;
         }
 
         case 0: {
-            break;
+                break;
         }
 
         default: {
-
-                for (int i = 0; i < 8; i++) {
-                        int rx = 0;
-                        for (int j = 8 - 1; j >= 0; j--) {
-                                if (((character_rom[c * 8 + i] >> j) & 1) == 1 && c != 0) {
-                                        ARC_FB_DRAW((void *)Arc_BootMeta.term.base, (sx + rx), (i + sy) * Arc_BootMeta.term.width, Arc_BootMeta.term.bpp, fg);
-                                }
-                                rx++;
-                        }
+                if (term_x >= term_cols) {
+                        term_newline();
                 }
-        
+
+                int ring = (term_top + term_y) % term_rows;
+                cells[ring * term_cols + term_x] = ((fg & 0xFFFFFF) << 8) | (uint8_t)c;
                 term_x++;
-        
+
+                row_len[ring] = max(row_len[ring], term_x);
+                dirty[term_y] = 1;
+
                 break;
         }
         }
 }
 
+void term_progress(int done, int total) {
+        if (term_fb == NULL || !term_splash || total <= 0) {
+                return;
+        }
+
+        // A bar across the middle half of the screen, a quarter of the way
+        // up from the bottom
+        int w = term_width / 2;
+        int h = term_cell / 2;
+        int x = term_width / 4;
+        int y = term_height - term_height / 4;
+
+        if (splash_filled < 0) {
+                fb_fill_rect(x, y, w, h, ARC_SPLASH_TRACK);
+                splash_filled = 0;
+        }
+
+        // Only the part of the bar which grew is drawn
+        int filled = w * min(done, total) / total;
+
+        if (filled > splash_filled) {
+                fb_fill_rect(x + splash_filled, y, filled - splash_filled, h, ARC_SPLASH_BAR);
+                splash_filled = filled;
+        }
+}
+
 void term_set_fg(uint32_t color) {
         fg = color;
 }
 
+uint32_t term_get_fg() {
+        return fg;
+}
+
 void init_uart() {
 	uint8_t lcr = inb(ARC_COM_PORT + 3);
 
@@ -124,17 +373,35 @@ void init_uart() {
 
 	// Set divisor to 1 for fastest communications
 	uint16_t divisor = 1;
-	uint8_t dlab = inb(ARC_COM_PORT + 3);
+	uint8_t dlab = lcr;
 	MASKED_WRITE(dlab, 1, 7, 1);
 	outb(ARC_COM_PORT + 3, dlab);
 
 	outb(ARC_COM_PORT, divisor & 0xFF);
 	outb(ARC_COM_PORT + 1, (divisor >> 8) & 0xFF);
 
+	// Enable and clear the FIFOs, with the 14 byte receive trigger. The
+	// 64 byte FIFO enable (bit 5) only sticks on a 16750, and only while
+	// DLAB is set
+	outb(ARC_COM_PORT + 2, 0xE7);
+
 	MASKED_WRITE(dlab, 0, 7, 1);
 	outb(ARC_COM_PORT + 3, dlab);
 
+	// IIR bits 6 and 7 are both set if the FIFOs are enabled and working,
+	// which rules out the 8250, 16450 and the original 16550
+	uint8_t iir = inb(ARC_COM_PORT + 2);
+
+	if (MASKED_READ(iir, 6, 0b11) == 0b11) {
+		uart_fifo = MASKED_READ(iir, 5, 1) ? 64 : 16;
+	} else {
+		outb(ARC_COM_PORT + 2, 0);
+		uart_fifo = 1;
+	}
+
+	uart_room = 0;
+
         uint8_t mcr = inb(ARC_COM_PORT + 4);
         MASKED_WRITE(mcr, 0, 4, 1);
         outb(ARC_COM_PORT + 4, mcr);
-}
\ No newline at end of file
+}
@@ -0,0 +1,285 @@
+/**
+ * @file mmap.c
+ *
+ * @author awewsomegamer <awewsomegamer@gmail.com>
+ *
+ * @LICENSE
+ * Arctan-OS/BSP-GRUB - GRUB bootstrapper for Arctan-OS/Kernel
+ * Copyright (C) 2023-2025 awewsomegamer
+ *
+ * This file is part of Arctan-OS/BSP-GRUB
+ *
+ * Arctan is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 2
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ * @DESCRIPTION
+ * Functions for building the ARC_MMap out of the (possibly overlapping)
+ * ranges reported by firmware.
+*/
+#define ARC_DEBUG_SUBSYS ARC_DEBUG_SUBSYS_MM
+
+#include <mm/mmap.h>
+#include <global.h>
+#include <inttypes.h>
+#include <util.h>
+
+// Number of ARC_MEMORY_* types tracked during the sweep, anything
+// else is treated as reserved
+#define MMAP_TYPE_COUNT 32
+
+struct mmap_event {
+	uint64_t addr;
+	uint32_t type;
+	// 1: range starts at addr, 0: range ends at addr
+	uint16_t start;
+	// 1: range is an overlay
+	uint16_t overlay;
+};
+
+// Storage of the ARC_MMap
+static uint64_t storage_base = 0;
+static int storage_capacity = 0;
+
+static int mmap_event_cmp(const void *a, const void *b) {
+	uint64_t x = ((struct mmap_event *)a)->addr;
+	uint64_t y = ((struct mmap_event *)b)->addr;
+
+	return (x > y) - (x < y);
+}
+
+static int mmap_add_events(struct mmap_event *e, struct ARC_MMap *ranges, int count, int overlay) {
+	int n = 0;
+
+	for (int i = 0; i < count; i++) {
+		uint64_t base = ranges[i].base;
+		uint64_t len = ranges[i].len;
+
+		if (len == 0 || base + len < base) {
+			continue;
+		}
+
+		uint32_t type = ranges[i].type < MMAP_TYPE_COUNT ? ranges[i].type : ARC_MEMORY_RESERVED;
+
+		e[n++] = (struct mmap_event){ .addr = base, .type = type, .start = 1, .overlay = overlay };
+		e[n++] = (struct mmap_event){ .addr = base + len, .type = type, .start = 0, .overlay = overlay };
+	}
+
+	return n;
+}
+
+int mmap_capacity(int count, int overlay_count) {
+	// Every boundary can start a new entry
+	return 2 * (count + overlay_count) + ARC_MMAP_HEADROOM;
+}
+
+size_t mmap_scratch_size(int count, int overlay_count) {
+	return 2 * (count + overlay_count) * sizeof(struct mmap_event);
+}
+
+int mmap_normalize(struct ARC_MMap *map, int count, int capacity, struct ARC_MMap *overlays, int overlay_count, void *scratch) {
+	if (map == NULL || scratch == NULL || count < 0 || overlay_count < 0) {
+		ARC_DEBUG(ERR, "Cannot normalise map of %d entries (%d overlays)\n", count, overlay_count);
+		return -1;
+	}
+
+	struct mmap_event *events = (struct mmap_event *)scratch;
+	int event_count = mmap_add_events(events, map, count, 0);
+
+	if (overlays != NULL) {
+		event_count += mmap_add_events(&events[event_count], overlays, overlay_count, 1);
+	}
+
+	hsort(events, event_count, sizeof(struct mmap_event), mmap_event_cmp);
+
+	// Number of ranges of each type covering the current address,
+	// and a bitmask of the types which are non-zero
+	uint16_t fw_active[MMAP_TYPE_COUNT] = { 0 };
+	uint16_t ov_active[MMAP_TYPE_COUNT] = { 0 };
+	uint32_t fw_mask = 0;
+	uint32_t ov_mask = 0;
+
+	int out = 0;
+	uint64_t prev = 0;
+
+	// Sweep the boundaries in ascending order, every span between two
+	// boundaries gets the type of the lowest active type
+	for (int i = 0; i < event_count;) {
+		uint64_t addr = events[i].addr;
+
+		if (addr > prev && fw_mask != 0) {
+			uint32_t type = __builtin_ctz(fw_mask | ov_mask);
+
+			if (out > 0 && map[out - 1].type == type && map[out - 1].base + map[out - 1].len == prev) {
+				map[out - 1].len += addr - prev;
+			} else if (out < capacity) {
+				map[out].base = prev;
+				map[out].len = addr - prev;
+				map[out].type = type;
+				out++;
+			} else {
+				ARC_DEBUG(ERR, "Normalised map exceeds %d entries\n", capacity);
+				return -1;
+			}
+		}
+
+		for (; i < event_count && events[i].addr == addr; i++) {
+			struct mmap_event *e = &events[i];
+			uint16_t *active = e->overlay ? ov_active : fw_active;
+			uint32_t *mask = e->overlay ? &ov_mask : &fw_mask;
+
+			if (e->start) {
+				active[e->type]++;
+			} else {
+				active[e->type]--;
+			}
+
+			if (active[e->type] == 0) {
+				*mask &= ~(1U << e->type);
+			} else {
+				*mask |= 1U << e->type;
+			}
+		}
+
+		prev = addr;
+	}
+
+	return out;
+}
+
+void mmap_use(struct ARC_MMap *map, int len, int capacity) {
+	storage_base = (uintptr_t)map;
+	storage_capacity = capacity;
+
+	Arc_KernelMeta.arc_mmap.base = (uintptr_t)map;
+	Arc_KernelMeta.arc_mmap.len = len;
+}
+
+int mmap_set_type(uint64_t base, uint64_t len, uint32_t type) {
+	struct ARC_MMap *map = (struct ARC_MMap *)(uintptr_t)Arc_KernelMeta.arc_mmap.base;
+	int count = Arc_KernelMeta.arc_mmap.len;
+	uint64_t end = base + len;
+
+	if (len == 0) {
+		return 0;
+	}
+
+	for (int i = 0; i < count; i++) {
+		struct ARC_MMap entry = map[i];
+		uint64_t entry_end = entry.base + entry.len;
+
+		if (entry_end <= base || entry.base >= end || entry.type == type) {
+			continue;
+		}
+
+		uint64_t lo = max(entry.base, base);
+		uint64_t hi = min(entry_end, end);
+		int extra = (entry.base < lo) + (hi < entry_end);
+
+		if (count + extra > storage_capacity) {
+			ARC_DEBUG(ERR, "ARC_MMap is full (%d entries)\n", storage_capacity);
+			return -1;
+		}
+
+		if (extra > 0 && i + 1 < count) {
+			nmemcpy(&map[i + 1 + extra], &map[i + 1], (count - i - 1) * sizeof(struct ARC_MMap));
+		}
+
+		count += extra;
+
+		if (entry.base < lo) {
+			map[i].base = entry.base;
+			map[i].len = lo - entry.base;
+			map[i].type = entry.type;
+			i++;
+		}
+
+		map[i].base = lo;
+		map[i].len = hi - lo;
+		map[i].type = type;
+
+		if (hi < entry_end) {
+			i++;
+			map[i].base = hi;
+			map[i].len = entry_end - hi;
+			map[i].type = entry.type;
+		}
+	}
+
+	// Coalesce neighbours which now share a type
+	int out = 0;
+	for (int i = 0; i < count; i++) {
+		if (out > 0 && map[out - 1].type == map[i].type && map[out - 1].base + map[out - 1].len == map[i].base) {
+			map[out - 1].len += map[i].len;
+			continue;
+		}
+
+		map[out++] = map[i];
+	}
+
+	Arc_KernelMeta.arc_mmap.len = out;
+
+	return 0;
+}
+
+int mmap_compact() {
+	uint64_t size = ALIGN((uint64_t)storage_capacity * sizeof(struct ARC_MMap), (uint64_t)PAGE_SIZE);
+	// Leave room for the split made by releasing the tail itself
+	uint64_t used = ALIGN((uint64_t)(Arc_KernelMeta.arc_mmap.len + 2) * sizeof(struct ARC_MMap), (uint64_t)PAGE_SIZE);
+
+	if (used >= size) {
+		return 0;
+	}
+
+	storage_capacity = used / sizeof(struct ARC_MMap);
+
+	return mmap_set_type(storage_base + used, size - used, ARC_MEMORY_AVAILABLE);
+}
+
+int mmap_check(struct ARC_MMap *map, int count, struct ARC_MMap *reservations, int reservation_count) {
+	int violations = 0;
+
+	for (int i = 0; i < count; i++) {
+		if (map[i].len == 0 || map[i].type > ARC_MEMORY_AVAILABLE) {
+			ARC_DEBUG(ERR, "MMap %d: empty or bad type (%d)\n", i, map[i].type);
+			violations++;
+		}
+
+		if (i == 0) {
+			continue;
+		}
+
+		uint64_t prev_end = map[i - 1].base + map[i - 1].len;
+
+		if (map[i].base < prev_end) {
+			ARC_DEBUG(ERR, "MMap %d: unsorted or overlaps previous entry\n", i);
+			violations++;
+		} else if (map[i].base == prev_end && map[i].type == map[i - 1].type) {
+			ARC_DEBUG(ERR, "MMap %d: not coalesced with previous entry\n", i);
+			violations++;
+		}
+	}
+
+	for (int i = 0; reservations != NULL && i < reservation_count; i++) {
+		uint64_t base = reservations[i].base;
+		uint64_t end = base + reservations[i].len;
+
+		for (int j = 0; j < count; j++) {
+			if (map[j].type == ARC_MEMORY_AVAILABLE && map[j].base < end && map[j].base + map[j].len > base) {
+				ARC_DEBUG(ERR, "MMap %d: reservation 0x%"PRIx64" -> 0x%"PRIx64" left available\n", j, base, end);
+				violations++;
+			}
+		}
+	}
+
+	return violations;
+}
@@ -25,75 +25,107 @@
  * @DESCRIPTION
  * Header file defining functions to manage and use a basic watermark allocator
 */
+#define ARC_DEBUG_SUBSYS ARC_DEBUG_SUBSYS_MM
+
 #include <mm/watermark.h>
 #include <global.h>
 #include <inttypes.h>
+#include <mm/mmap.h>
 
-static int current_entry = -1;
+// Region of the ARC_MMap currently being allocated from, tracked by
+// address as the map's indices shift whenever it is split
+static uint64_t region_base = 0;
+static uint64_t region_len = 0;
 static size_t watermark_off = 0;
 
 static int watermark_get_new_base() {
+        // Retire the current region entirely
+        if (region_len != 0 && mmap_set_type(region_base, region_len, ARC_MEMORY_BOOTSTRAP_ALLOC) != 0) {
+                return -1;
+        }
+
         struct ARC_MMap *mmap = (struct ARC_MMap *)Arc_KernelMeta.arc_mmap.base;
 
         int largest = -1;
+        uint64_t largest_len = 0;
         for (int i = 0; i < Arc_KernelMeta.arc_mmap.len; i++) {
                 if (mmap[i].type != ARC_MEMORY_AVAILABLE || 
                         mmap[i].base < 0x100000 || mmap[i].base >= UINT32_MAX) {
                         continue;
                 }
+
+                // Only the part below 4 GiB can be written to
+                uint64_t len = min(mmap[i].base + mmap[i].len, (uint64_t)UINT32_MAX + 1) - mmap[i].base;
                 
-                if (largest == - 1 || mmap[largest].len < mmap[i].len) {
+                if (largest == - 1 || largest_len < len) {
                         largest = i;
+                        largest_len = len;
                 }
         }
-                
-        
-        if (current_entry != -1) {
-                mmap[current_entry].type = ARC_MEMORY_BOOTSTRAP_ALLOC;
-        }
+
+        region_base = 0;
+        region_len = 0;
+        watermark_off = 0;
 
         if (largest == -1) {
                 return -1;
         }
 
-        current_entry = largest;
-        watermark_off = 0;
+        region_base = mmap[largest].base;
+        region_len = largest_len;
 
         return 0;
 }
 
 int watermark_update_mmap() {
-        if (current_entry == -1) {
+        if (region_len == 0) {
                 return watermark_get_new_base();
         }
 
-        struct ARC_MMap *mmap = (struct ARC_MMap *)Arc_KernelMeta.arc_mmap.base;
-
-        nmemcpy(&mmap[current_entry + 1], &mmap[current_entry], sizeof(struct ARC_MMap) * (Arc_KernelMeta.arc_mmap.len - 1));
-        Arc_KernelMeta.arc_mmap.len++;
+        if (watermark_off == 0) {
+                return 0;
+        }
 
-        mmap[current_entry + 1].base += watermark_off;
-        mmap[current_entry + 1].len -= watermark_off;
+        // Mark what has been allocated so far and continue after it
+        if (mmap_set_type(region_base, watermark_off, ARC_MEMORY_BOOTSTRAP_ALLOC) != 0) {
+                return -1;
+        }
 
-        mmap[current_entry].len = watermark_off;
-        mmap[current_entry].type = ARC_MEMORY_BOOTSTRAP_ALLOC;
+        region_base += watermark_off;
+        region_len -= watermark_off;
+        watermark_off = 0;
 
         return 0;
 }
 
-void *alloc(size_t size) {
-        struct ARC_MMap *mmap = (struct ARC_MMap *)Arc_KernelMeta.arc_mmap.base;
-
+void *alloc_aligned(size_t size, size_t align) {
         size = ALIGN(size, PAGE_SIZE);
+        align = max(align, (size_t)PAGE_SIZE);
+
+        uint64_t base = region_base;
+        uint64_t off = ALIGN(base + watermark_off, (uint64_t)align) - base;
+
+        if (region_len == 0 || off + size > region_len) {
+                if (watermark_get_new_base() != 0) {
+                        ARC_DEBUG(ERR, "Overflow, can't rebase\n");
+                        return NULL;
+                }
+
+                base = region_base;
+                off = ALIGN(base, (uint64_t)align) - base;
 
-        if (watermark_off + size > mmap[current_entry].base + mmap[current_entry].len
-                && watermark_get_new_base() != 0) {
-                ARC_DEBUG(ERR, "Overflow, can't rebase\n");
-                return NULL;
+                if (off + size > region_len) {
+                        ARC_DEBUG(ERR, "Overflow, can't fit 0x%"PRIx64" B\n", (uint64_t)size);
+                        return NULL;
+                }
         }
 
-        void *a = (void *)(mmap[current_entry].base + watermark_off);
-        watermark_off += size;
+        void *a = (void *)(uintptr_t)(base + off);
+        watermark_off = off + size;
 
         return a;
-}
\ No newline at end of file
+}
+
+void *alloc(size_t size) {
+        return alloc_aligned(size, PAGE_SIZE);
+}
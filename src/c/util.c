@@ -41,12 +41,34 @@ int strcmp(char *a, char *b) {
 	return ca - cb;
 }
 
+int strncmp(char *a, char *b, size_t n) {
+	for (size_t i = 0; i < n; i++) {
+		uint8_t ca = (uint8_t)a[i];
+		uint8_t cb = (uint8_t)b[i];
+
+		if (ca != cb || ca == 0) {
+			return ca - cb;
+		}
+	}
+
+	return 0;
+}
+
 int memcpy(void *a, void *b, size_t size) {
+#if defined(ARC_TARGET_ARCH_X86_64) || defined(ARC_TARGET_ARCH_X86)
+	// Copy as many dwords as possible, then the remaining bytes
+	size_t dwords = size >> 2;
+	size_t bytes = size & 3;
+
+	__asm__ volatile("rep movsd" : "+D"(a), "+S"(b), "+c"(dwords) : : "memory");
+	__asm__ volatile("rep movsb" : "+D"(a), "+S"(b), "+c"(bytes) : : "memory");
+#else
 	size_t i = 0;
 	while (i < size) {
 		*(uint8_t *)(a + i) = *(uint8_t *)(b + i);
 		i++;
 	}
+#endif
 
 	return 0;
 }
@@ -110,7 +132,60 @@ int wordcpy(void *a, void *b, size_t size, int word_size) {
 
 
 void memset(void *mem, uint8_t value, size_t size) {
+#if defined(ARC_TARGET_ARCH_X86_64) || defined(ARC_TARGET_ARCH_X86)
+	uint32_t fill = value * 0x01010101;
+	size_t dwords = size >> 2;
+	size_t bytes = size & 3;
+
+	__asm__ volatile("rep stosd" : "+D"(mem), "+c"(dwords) : "a"(fill) : "memory");
+	__asm__ volatile("rep stosb" : "+D"(mem), "+c"(bytes) : "a"(fill) : "memory");
+#else
 	for (size_t i = 0; i < size; i++) {
 		*(uint8_t *)(mem + i) = value;
 	}
+#endif
+}
+
+static void hsort_swap(uint8_t *a, uint8_t *b, size_t size) {
+	for (size_t i = 0; i < size; i++) {
+		uint8_t t = a[i];
+		a[i] = b[i];
+		b[i] = t;
+	}
+}
+
+static void hsort_sift(uint8_t *base, size_t root, size_t count, size_t size, int (*cmp)(const void *, const void *)) {
+	size_t child;
+
+	while ((child = 2 * root + 1) < count) {
+		// Pick the larger of the two children
+		if (child + 1 < count && cmp(base + child * size, base + (child + 1) * size) < 0) {
+			child++;
+		}
+
+		if (cmp(base + root * size, base + child * size) >= 0) {
+			return;
+		}
+
+		hsort_swap(base + root * size, base + child * size, size);
+		root = child;
+	}
+}
+
+void hsort(void *base, size_t count, size_t size, int (*cmp)(const void *, const void *)) {
+	uint8_t *b = (uint8_t *)base;
+
+	if (count < 2) {
+		return;
+	}
+
+	// Build a max heap, then repeatedly move the root to the end
+	for (size_t i = count / 2; i > 0; i--) {
+		hsort_sift(b, i - 1, count, size, cmp);
+	}
+
+	for (size_t end = count - 1; end > 0; end--) {
+		hsort_swap(b, b + end * size, size);
+		hsort_sift(b, 0, end, size, cmp);
+	}
 }
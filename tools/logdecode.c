@@ -0,0 +1,322 @@
+/**
+ * @file logdecode.c
+ *
+ * @author awewsomegamer <awewsomegamer@gmail.com>
+ *
+ * @LICENSE
+ * Arctan-OS/BSP-GRUB - GRUB bootstrapper for Arctan-OS/Kernel
+ * Copyright (C) 2023-2025 awewsomegamer
+ *
+ * This file is part of Arctan-OS/BSP-GRUB
+ *
+ * Arctan is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 2
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ * @DESCRIPTION
+ * Host tool turning a tokenised boot log (ARC_DEBUG_TOKENS) back into
+ * text, using the .arc_logtab section of bootstrap.elf.
+ * 
+ * Usage: logdecode <bootstrap.elf> [capture]
+ * 
+ * The capture is read from stdin if it is not given. Bytes outside of
+ * records are copied through untouched.
+*/
+#include <elf.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Keep in sync with src/c/include/interface/logtoken.h
+#define ARC_LOG_TOKEN_MARK 0xFF
+#define ARC_LOG_TOKEN_STR 0x80
+
+struct log_arg {
+	int string;
+	uint64_t word;
+	char str[256];
+};
+
+static char *table = NULL;
+static uint32_t table_size = 0;
+static uint32_t table_addr = 0;
+
+static int load_table(char *path) {
+	FILE *file = fopen(path, "rb");
+
+	if (file == NULL) {
+		perror(path);
+		return -1;
+	}
+
+	fseek(file, 0, SEEK_END);
+	long size = ftell(file);
+	fseek(file, 0, SEEK_SET);
+
+	uint8_t *data = malloc(size);
+
+	if (data == NULL || fread(data, 1, size, file) != (size_t)size) {
+		fprintf(stderr, "Failed to read %s\n", path);
+		fclose(file);
+		return -1;
+	}
+
+	fclose(file);
+
+	Elf32_Ehdr *header = (Elf32_Ehdr *)data;
+
+	if (size < (long)sizeof(*header) || memcmp(header->e_ident, ELFMAG, SELFMAG) != 0
+	    || header->e_ident[EI_CLASS] != ELFCLASS32 || header->e_shstrndx == SHN_UNDEF
+	    || header->e_shoff + (uint64_t)header->e_shnum * sizeof(Elf32_Shdr) > (uint64_t)size) {
+		fprintf(stderr, "%s is not a 32-bit ELF with section headers\n", path);
+		return -1;
+	}
+
+	Elf32_Shdr *sections = (Elf32_Shdr *)(data + header->e_shoff);
+	char *names = (char *)(data + sections[header->e_shstrndx].sh_offset);
+
+	for (int i = 0; i < header->e_shnum; i++) {
+		if (strcmp(names + sections[i].sh_name, ".arc_logtab") != 0) {
+			continue;
+		}
+
+		if (sections[i].sh_offset + (uint64_t)sections[i].sh_size > (uint64_t)size) {
+			break;
+		}
+
+		table = (char *)(data + sections[i].sh_offset);
+		table_size = sections[i].sh_size;
+		// 0 in bootstrap.elf, records hold the string's address
+		table_addr = sections[i].sh_addr;
+
+		return 0;
+	}
+
+	fprintf(stderr, "%s has no .arc_logtab section, was it built with ARC_DEBUG_TOKENS?\n", path);
+
+	return -1;
+}
+
+static int read_bytes(FILE *in, uint8_t *to, int count) {
+	return fread(to, 1, count, in) == (size_t)count ? 0 : -1;
+}
+
+static int read_arg(FILE *in, struct log_arg *arg) {
+	uint8_t kind = 0;
+
+	if (read_bytes(in, &kind, 1) != 0) {
+		return -1;
+	}
+
+	memset(arg, 0, sizeof(*arg));
+
+	if (kind == ARC_LOG_TOKEN_STR) {
+		uint8_t len = 0;
+
+		if (read_bytes(in, &len, 1) != 0 || read_bytes(in, (uint8_t *)arg->str, len) != 0) {
+			return -1;
+		}
+
+		arg->string = 1;
+
+		return 0;
+	}
+
+	if (kind > sizeof(uint64_t)) {
+		return -1;
+	}
+
+	uint8_t bytes[sizeof(uint64_t)] = { 0 };
+
+	if (read_bytes(in, bytes, kind) != 0) {
+		return -1;
+	}
+
+	for (int i = 0; i < kind; i++) {
+		arg->word |= (uint64_t)bytes[i] << (i * 8);
+	}
+
+	return 0;
+}
+
+/**
+ * Print a record's format string with its arguments.
+ *
+ * Argument words are as wide as the type they came from on the
+ * (32-bit) target, so the length modifier decides how they are extended.
+ * */
+static void print_record(const char *format, struct log_arg *args, int nargs) {
+	int next = 0;
+
+	for (const char *c = format; *c != 0; c++) {
+		if (*c != '%') {
+			putchar(*c);
+			continue;
+		}
+
+		char spec[64] = "%";
+		int len = 1;
+
+		c++;
+
+		// Flags, width and precision are passed on to printf, with any
+		// '*' replaced by the argument it takes
+		while (*c != 0 && strchr("-+ #0123456789.*", *c) != NULL && len < 32) {
+			if (*c == '*') {
+				int value = next < nargs ? (int)(int32_t)args[next++].word : 0;
+				len += snprintf(spec + len, sizeof(spec) - len, "%d", value);
+			} else {
+				spec[len++] = *c;
+			}
+
+			c++;
+		}
+
+		int wide = 0;
+
+		while (*c != 0 && strchr("hlzjt", *c) != NULL) {
+			wide |= *c == 'j' || (*c == 'l' && c[1] == 'l');
+			c++;
+		}
+
+		if (*c == 0) {
+			break;
+		}
+
+		if (*c == '%') {
+			putchar('%');
+			continue;
+		}
+
+		if (next >= nargs) {
+			printf("<missing>");
+			continue;
+		}
+
+		struct log_arg *arg = &args[next++];
+
+		switch (*c) {
+		case 'd':
+		case 'i': {
+			int64_t value = wide ? (int64_t)arg->word : (int32_t)arg->word;
+			snprintf(spec + len, sizeof(spec) - len, "lld");
+			printf(spec, (long long)value);
+			break;
+		}
+
+		case 'u':
+		case 'x':
+		case 'X':
+		case 'o': {
+			uint64_t value = wide ? arg->word : (uint32_t)arg->word;
+			snprintf(spec + len, sizeof(spec) - len, "ll%c", *c);
+			printf(spec, (unsigned long long)value);
+			break;
+		}
+
+		case 'c': {
+			snprintf(spec + len, sizeof(spec) - len, "c");
+			printf(spec, (int)(uint8_t)arg->word);
+			break;
+		}
+
+		case 's': {
+			if (!arg->string) {
+				printf("<0x%llx>", (unsigned long long)arg->word);
+				break;
+			}
+
+			snprintf(spec + len, sizeof(spec) - len, "s");
+			printf(spec, arg->str);
+			break;
+		}
+
+		case 'p': {
+			printf("0x%08llx", (unsigned long long)arg->word);
+			break;
+		}
+
+		default: {
+			printf("<%%%c 0x%llx>", *c, (unsigned long long)arg->word);
+			break;
+		}
+		}
+	}
+}
+
+int main(int argc, char **argv) {
+	if (argc < 2) {
+		fprintf(stderr, "Usage: %s <bootstrap.elf> [capture]\n", argv[0]);
+		return 1;
+	}
+
+	if (load_table(argv[1]) != 0) {
+		return 1;
+	}
+
+	FILE *in = stdin;
+
+	if (argc > 2 && (in = fopen(argv[2], "rb")) == NULL) {
+		perror(argv[2]);
+		return 1;
+	}
+
+	int c = 0;
+
+	while ((c = fgetc(in)) != EOF) {
+		if (c != ARC_LOG_TOKEN_MARK) {
+			putchar(c);
+			continue;
+		}
+
+		uint8_t header[5] = { 0 };
+
+		if (read_bytes(in, header, 5) != 0) {
+			fprintf(stderr, "Capture ends inside a record\n");
+			break;
+		}
+
+		uint32_t id = header[0] | header[1] << 8 | header[2] << 16 | (uint32_t)header[3] << 24;
+		int nargs = header[4];
+		struct log_arg args[256];
+		int i = 0;
+
+		for (; i < nargs; i++) {
+			if (read_arg(in, &args[i]) != 0) {
+				break;
+			}
+		}
+
+		if (i != nargs) {
+			fprintf(stderr, "Malformed record for 0x%x\n", id);
+			break;
+		}
+
+		uint32_t offset = id - table_addr;
+
+		// Strings are terminated in the table, so the last byte of a
+		// valid one is always within it
+		if (offset >= table_size || memchr(table + offset, 0, table_size - offset) == NULL) {
+			printf("<unknown log record 0x%x>\n", id);
+			continue;
+		}
+
+		print_record(table + offset, args, nargs);
+	}
+
+	if (in != stdin) {
+		fclose(in);
+	}
+
+	return 0;
+}
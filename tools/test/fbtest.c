@@ -0,0 +1,145 @@
+/**
+ * @file fbtest.c
+ *
+ * @author awewsomegamer <awewsomegamer@gmail.com>
+ *
+ * @LICENSE
+ * Arctan-OS/BSP-GRUB - GRUB bootstrapper for Arctan-OS/Kernel
+ * Copyright (C) 2023-2025 awewsomegamer
+ *
+ * This file is part of Arctan-OS/BSP-GRUB
+ *
+ * Arctan is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 2
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ * @DESCRIPTION
+ * Host test of the framebuffer primitives against a simulated framebuffer.
+ * 
+ * The framebuffer is 37x23 with a pitch well past its width, at 16, 24
+ * and 32 bpp. Random fills, many partly off screen on every side, are
+ * mirrored by a per-pixel reference, and the whole buffer, padding
+ * included, must match after each one.
+ * 
+ * Usage: fbtest [fills per depth] [seed]
+*/
+#include "host.h"
+#include <interface/fb.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define WIDTH 37
+#define HEIGHT 23
+#define PITCH 200
+
+static uint8_t fb[PITCH * HEIGHT];
+static uint8_t ref[PITCH * HEIGHT];
+static int bytes = 0;
+
+static void ref_put(uint8_t *buffer, int x, int y, uint32_t color) {
+	if (x < 0 || y < 0 || x >= WIDTH || y >= HEIGHT) {
+		return;
+	}
+
+	uint8_t *pixel = buffer + y * PITCH + x * bytes;
+
+	for (int i = 0; i < bytes; i++) {
+		pixel[i] = color >> (8 * i);
+	}
+}
+
+// Coordinates from a little past the top left to past the bottom right
+static int rand_coord(uint64_t *state, int size) {
+	return (int)(host_rand(state) % (size + 30)) - 15;
+}
+
+static int check_init() {
+	int failures = 0;
+
+	failures += fb_init(fb, WIDTH, HEIGHT, PITCH, 8) != -1;
+	failures += fb_init(fb, WIDTH, HEIGHT, WIDTH * 4 - 1, 32) != -1;
+	failures += fb_init(NULL, WIDTH, HEIGHT, PITCH, 32) != -1;
+
+	if (failures != 0) {
+		fprintf(stderr, "fb_init accepted a framebuffer it cannot draw to\n");
+	}
+
+	// Nothing is drawn without a framebuffer
+	memset(fb, 0, sizeof(fb));
+	fb_fill_rect(0, 0, WIDTH, HEIGHT, 0xFFFFFFFF);
+
+	for (size_t i = 0; i < sizeof(fb); i++) {
+		if (fb[i] != 0) {
+			fprintf(stderr, "Drew to a framebuffer fb_init refused\n");
+			return failures + 1;
+		}
+	}
+
+	return failures;
+}
+
+static int run_depth(int bpp, int fills, uint64_t seed) {
+	uint64_t state = seed;
+	uint32_t mask = bpp == 32 ? 0xFFFFFFFF : (1U << bpp) - 1;
+
+	bytes = bpp / 8;
+
+	for (size_t i = 0; i < sizeof(fb); i++) {
+		fb[i] = ref[i] = host_rand(&state);
+	}
+
+	if (fb_init(fb, WIDTH, HEIGHT, PITCH, bpp) != 0 || fb_pitch() != PITCH || fb_bytes() != bytes
+	    || fb_pixel(3, 2) != fb + 2 * PITCH + 3 * bytes) {
+		fprintf(stderr, "%d bpp: framebuffer described wrongly\n", bpp);
+		return -1;
+	}
+
+	for (int op = 0; op < fills; op++) {
+		int x = rand_coord(&state, WIDTH);
+		int y = rand_coord(&state, HEIGHT);
+		int w = host_rand(&state) % 30;
+		int h = host_rand(&state) % 20;
+		uint32_t color = host_rand(&state) & mask;
+
+		fb_fill_rect(x, y, w, h, color);
+
+		for (int j = 0; j < h; j++) {
+			for (int i = 0; i < w; i++) {
+				ref_put(ref, x + i, y + j, color);
+			}
+		}
+
+		if (memcmp(fb, ref, sizeof(fb)) != 0) {
+			fprintf(stderr, "%d bpp: fill %d at %d,%d %dx%d differs from the reference\n", bpp, op, x, y, w, h);
+			return -1;
+		}
+	}
+
+	return 0;
+}
+
+int main(int argc, char **argv) {
+	int fills = argc > 1 ? atoi(argv[1]) : 20000;
+	uint64_t seed = argc > 2 ? strtoull(argv[2], NULL, 0) : 1;
+	int failed = check_init() != 0;
+
+	for (int bpp = 16; bpp <= 32; bpp += 8) {
+		if (run_depth(bpp, fills, seed) != 0) {
+			failed++;
+		}
+	}
+
+	printf("fbtest: %s\n", failed == 0 ? "all fills matched the reference" : "FAILED");
+
+	return failed == 0 ? 0 : 1;
+}
@@ -0,0 +1,66 @@
+/**
+ * @file host.h
+ *
+ * @author awewsomegamer <awewsomegamer@gmail.com>
+ *
+ * @LICENSE
+ * Arctan-OS/BSP-GRUB - GRUB bootstrapper for Arctan-OS/Kernel
+ * Copyright (C) 2023-2025 awewsomegamer
+ *
+ * This file is part of Arctan-OS/BSP-GRUB
+ *
+ * Arctan is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 2
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ * @DESCRIPTION
+ * Declarations shared by the host tests, which link parts of the
+ * bootstrapper against tools/test/stubs.c instead of the rest of it.
+ * 
+ * Host test files must not include util.h: the bootstrapper's memcpy,
+ * memset, strcmp and strncmp are built renamed (see HOST_TEST_CPPFLAGS in
+ * the Makefile) so they do not clash with the C library.
+*/
+#ifndef ARC_TOOLS_TEST_HOST_H
+#define ARC_TOOLS_TEST_HOST_H
+
+#include <arctan.h>
+#include <stdint.h>
+
+extern struct ARC_KernelMeta Arc_KernelMeta;
+extern struct ARC_BootMeta Arc_BootMeta;
+extern struct ARC_BootTunables Arc_BootTunables;
+
+// Number of modules passed to module_register
+extern int host_module_count;
+// Number of messages printed, only errors are without ARC_DEBUG_ENABLE
+extern int host_log_count;
+// Suppress printing messages, they are still counted
+extern int host_log_quiet;
+
+#define HOST_PAGE_SIZE 0x1000
+#define HOST_ALIGN(v, a) (((v) + ((a) - 1)) & ~((uint64_t)(a) - 1))
+
+/**
+ * Small deterministic PRNG so failures can be reproduced from a seed.
+ * */
+static inline uint64_t host_rand(uint64_t *state) {
+	uint64_t x = *state;
+
+	x ^= x << 13;
+	x ^= x >> 7;
+	x ^= x << 17;
+
+	return *state = x;
+}
+
+#endif
@@ -0,0 +1,418 @@
+/**
+ * @file mb2test.c
+ *
+ * @author awewsomegamer <awewsomegamer@gmail.com>
+ *
+ * @LICENSE
+ * Arctan-OS/BSP-GRUB - GRUB bootstrapper for Arctan-OS/Kernel
+ * Copyright (C) 2023-2025 awewsomegamer
+ *
+ * This file is part of Arctan-OS/BSP-GRUB
+ *
+ * Arctan is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 2
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ * @DESCRIPTION
+ * Host test feeding randomised Multiboot2 information structures to
+ * parse_mb2i.
+ * 
+ * Each case builds a tag blob with a 500+ entry E820 map of overlapping,
+ * oddly aligned ranges of every type (including unknown ones) and up to
+ * ARC_BSP_MAX_MODULES modules, parses it in a child process, and checks the
+ * resulting ARC_MMap with mmap_check and against the blob. Afterwards the
+ * parse is timed per entry over growing maps, so a regression to quadratic
+ * behaviour fails the test.
+ * 
+ * Usage: mb2test [cases] [first seed]
+*/
+#include "host.h"
+#include <boot/mb2parse.h>
+#include <boot/module.h>
+#include <boot/multiboot2.h>
+#include <inttypes.h>
+#include <mm/mmap.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+// Memory standing in for physical memory below 4 GiB. Every available
+// range below 4 GiB lies in it, so wherever the ARC_MMap is placed can
+// be written to. The blob is built at its start and its top is only ever
+// available, so the map always fits
+#define ARENA_SIZE (64 << 20)
+#define ARENA_BLOB (4 << 20)
+#define ARENA_FREE (8 << 20)
+
+#define MIN_ENTRIES 500
+#define MAX_ENTRIES 2000
+
+// Per entry parse time may grow by at most this much from the smallest
+// to the largest map timed
+#define PERF_MAX_GROWTH 4.0
+#define PERF_RUNS 5
+
+struct case_result {
+	int passed;
+	int entries;
+	uint64_t ns;
+};
+
+struct range {
+	uint64_t base;
+	uint64_t len;
+	uint32_t type;
+};
+
+static uint8_t *arena = NULL;
+
+static uint64_t addr(void *p) {
+	return (uint64_t)(uintptr_t)p;
+}
+
+static uint64_t rand_below(uint64_t *state, uint64_t n) {
+	return n == 0 ? 0 : host_rand(state) % n;
+}
+
+static uint32_t rand_reserved_type(uint64_t *state) {
+	static const uint32_t types[] = {
+		MULTIBOOT_MEMORY_RESERVED, MULTIBOOT_MEMORY_ACPI_RECLAIMABLE,
+		MULTIBOOT_MEMORY_NVS, MULTIBOOT_MEMORY_BADRAM, 9, 17, 0xF00D,
+	};
+
+	return types[rand_below(state, sizeof(types) / sizeof(*types))];
+}
+
+/**
+ * Generate a firmware memory map, keeping available memory below 4 GiB
+ * within the arena and the top of the arena free of anything else.
+ * */
+static int generate_mmap(uint64_t *state, struct range *out, int count) {
+	uint64_t lo = addr(arena) + ARENA_BLOB;
+	uint64_t hi = addr(arena) + ARENA_SIZE;
+	uint64_t free_lo = hi - ARENA_FREE;
+
+	for (int i = 0; i < count - 1; i++) {
+		struct range *r = &out[i];
+
+		switch (rand_below(state, 10)) {
+			case 0: case 1: case 2: case 3: case 4: {
+				r->base = lo + rand_below(state, hi - lo - 1);
+				r->len = 1 + rand_below(state, hi - r->base < 0x100000 ? hi - r->base : 0x100000);
+				r->type = MULTIBOOT_MEMORY_AVAILABLE;
+				break;
+			}
+
+			case 5: case 6: {
+				r->base = lo + rand_below(state, free_lo - lo - 1);
+				r->len = 1 + rand_below(state, free_lo - r->base < 0x40000 ? free_lo - r->base : 0x40000);
+				r->type = rand_reserved_type(state);
+				break;
+			}
+
+			case 7: {
+				r->base = 0x100000000 + rand_below(state, (uint64_t)1 << 40);
+				r->len = rand_below(state, (uint64_t)1 << 32);
+				r->type = rand_below(state, 2) ? MULTIBOOT_MEMORY_AVAILABLE : rand_reserved_type(state);
+				break;
+			}
+
+			case 8: {
+				// Below 4 GiB outside of the arena, where firmware
+				// puts MMIO and ROMs
+				r->base = rand_below(state, addr(arena));
+				r->len = 1 + rand_below(state, addr(arena) - r->base < 0x100000 ? addr(arena) - r->base : 0x100000);
+				r->type = rand_reserved_type(state);
+				break;
+			}
+
+			default: {
+				// Empty and single byte ranges
+				r->base = lo + rand_below(state, free_lo - lo);
+				r->len = rand_below(state, 2);
+				r->type = rand_below(state, 2) ? MULTIBOOT_MEMORY_AVAILABLE : rand_reserved_type(state);
+				break;
+			}
+		}
+	}
+
+	// Put the free top of the arena at a random position
+	int top = rand_below(state, count);
+	out[count - 1] = out[top];
+	out[top] = (struct range){ .base = free_lo, .len = ARENA_FREE, .type = MULTIBOOT_MEMORY_AVAILABLE };
+
+	return count;
+}
+
+static uint8_t *put_tag(uint8_t *at, uint32_t type, uint32_t size) {
+	struct multiboot_tag *tag = (struct multiboot_tag *)at;
+
+	tag->type = type;
+	tag->size = size;
+
+	return at + HOST_ALIGN(size, 8);
+}
+
+/**
+ * Build the information structure at the start of the arena.
+ *
+ * @return Number of reservations written to resv.
+ * */
+static int build_blob(uint64_t *state, struct range *mmap, int count, struct range *resv) {
+	uint8_t *blob = arena;
+	uint8_t *at = blob + 8;
+	int resv_count = 0;
+	int modules = rand_below(state, ARC_BSP_MAX_MODULES + 1);
+	uint64_t lo = addr(arena) + ARENA_BLOB;
+	uint64_t free_lo = addr(arena) + ARENA_SIZE - ARENA_FREE;
+
+	for (int i = 0; i < modules; i++) {
+		struct multiboot_tag_module *module = (struct multiboot_tag_module *)at;
+		int len = snprintf(module->cmdline, 32, "module.%d", i) + 1;
+
+		module->mod_start = lo + rand_below(state, free_lo - lo - 0x80000);
+		module->mod_end = module->mod_start + 1 + rand_below(state, 0x80000);
+
+		resv[resv_count++] = (struct range){ .base = module->mod_start, .len = module->mod_end - module->mod_start };
+		at = put_tag(at, MULTIBOOT_TAG_TYPE_MODULE, sizeof(*module) + len);
+	}
+
+	struct multiboot_tag_mmap *tag = (struct multiboot_tag_mmap *)at;
+	tag->entry_size = sizeof(struct multiboot_mmap_entry);
+	tag->entry_version = 0;
+
+	for (int i = 0; i < count; i++) {
+		tag->entries[i].addr = mmap[i].base;
+		tag->entries[i].len = mmap[i].len;
+		tag->entries[i].type = mmap[i].type;
+		tag->entries[i].zero = 0;
+	}
+
+	at = put_tag(at, MULTIBOOT_TAG_TYPE_MMAP, sizeof(*tag) + count * sizeof(struct multiboot_mmap_entry));
+	at = put_tag(at, MULTIBOOT_TAG_TYPE_END, 8);
+
+	*(uint32_t *)blob = at - blob;
+	*(uint32_t *)(blob + 4) = 0;
+
+	resv[resv_count++] = (struct range){ .base = addr(blob), .len = at - blob };
+
+	return resv_count;
+}
+
+static int overlaps(uint64_t base, uint64_t len, struct range *r) {
+	return r->base < base + len && r->base + r->len > base;
+}
+
+/**
+ * Parse one blob and check the result, run in a child process as the
+ * parser keeps its state in statics.
+ * */
+static int run_case(uint64_t seed, int entries, struct case_result *result) {
+	uint64_t state = seed;
+	static struct range mmap[MAX_ENTRIES * 8];
+	struct range resv[ARC_BSP_MAX_MODULES + 1];
+
+	if (entries == 0) {
+		entries = MIN_ENTRIES + rand_below(&state, MAX_ENTRIES - MIN_ENTRIES);
+	}
+
+	generate_mmap(&state, mmap, entries);
+	int resv_count = build_blob(&state, mmap, entries, resv);
+
+	struct timespec start, end;
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	int r = parse_mb2i(arena);
+	clock_gettime(CLOCK_MONOTONIC, &end);
+
+	result->entries = entries;
+	result->ns = (end.tv_sec - start.tv_sec) * 1000000000ULL + (end.tv_nsec - start.tv_nsec);
+
+	if (r != 0) {
+		fprintf(stderr, "seed %"PRIu64": parse_mb2i returned %d\n", seed, r);
+		return -1;
+	}
+
+	int failures = 0;
+
+	// There is no command line tag, the defaults still go to the kernel
+	if (Arc_KernelMeta.tunables != (uintptr_t)&Arc_BootTunables || Arc_KernelMeta.cmdline != 0) {
+		fprintf(stderr, "seed %"PRIu64": tunables not handed over without a command line\n", seed);
+		failures++;
+	}
+
+	if (host_module_count != resv_count - 1) {
+		fprintf(stderr, "seed %"PRIu64": %d of %d modules registered\n", seed, host_module_count, resv_count - 1);
+		failures++;
+	}
+
+	struct ARC_MMap *map = (struct ARC_MMap *)(uintptr_t)Arc_KernelMeta.arc_mmap.base;
+	int len = Arc_KernelMeta.arc_mmap.len;
+	uint64_t storage = addr(map);
+	uint64_t storage_len = len * sizeof(struct ARC_MMap);
+
+	// The map lives in memory the firmware reported available, clear of
+	// everything else
+	if (storage < addr(arena) + ARENA_BLOB || storage + storage_len > addr(arena) + ARENA_SIZE) {
+		fprintf(stderr, "seed %"PRIu64": ARC_MMap placed outside of available memory (0x%"PRIx64")\n", seed, storage);
+		return -1;
+	}
+
+	for (int i = 0; i < entries; i++) {
+		if (mmap[i].type != MULTIBOOT_MEMORY_AVAILABLE && overlaps(storage, storage_len, &mmap[i])) {
+			fprintf(stderr, "seed %"PRIu64": ARC_MMap overlaps firmware range %d\n", seed, i);
+			failures++;
+		}
+	}
+
+	for (int i = 0; i < resv_count; i++) {
+		if (overlaps(storage, storage_len, &resv[i])) {
+			fprintf(stderr, "seed %"PRIu64": ARC_MMap overlaps reservation %d\n", seed, i);
+			failures++;
+		}
+	}
+
+	struct ARC_MMap overlays[ARC_BSP_MAX_MODULES + 2];
+	for (int i = 0; i < resv_count; i++) {
+		overlays[i] = (struct ARC_MMap){ .base = resv[i].base, .len = resv[i].len, .type = ARC_MEMORY_BOOTSTRAP };
+	}
+	overlays[resv_count] = (struct ARC_MMap){ .base = storage, .len = storage_len, .type = ARC_MEMORY_BOOTSTRAP_ALLOC };
+
+	int violations = mmap_check(map, len, overlays, resv_count + 1);
+
+	if (violations != 0) {
+		fprintf(stderr, "seed %"PRIu64": %d ARC_MMap invariant violations\n", seed, violations);
+		failures++;
+	}
+
+	if (len > 0 && Arc_BootMeta.mem_size != map[len - 1].base + map[len - 1].len) {
+		fprintf(stderr, "seed %"PRIu64": memory size does not match the ARC_MMap\n", seed);
+		failures++;
+	}
+
+	return failures == 0 ? 0 : -1;
+}
+
+static int fork_case(uint64_t seed, int entries, struct case_result *result) {
+	memset(result, 0, sizeof(*result));
+
+	pid_t pid = fork();
+
+	if (pid < 0) {
+		perror("fork");
+		return -1;
+	}
+
+	if (pid == 0) {
+		// Errors for malformed input are expected to be printed, the
+		// checks above say what went wrong
+		host_log_quiet = getenv("MB2TEST_VERBOSE") == NULL;
+		result->passed = run_case(seed, entries, result) == 0;
+		_exit(0);
+	}
+
+	int status = 0;
+	waitpid(pid, &status, 0);
+
+	if (!WIFEXITED(status)) {
+		fprintf(stderr, "seed %"PRIu64": crashed (status 0x%x)\n", seed, status);
+		return -1;
+	}
+
+	return result->passed ? 0 : -1;
+}
+
+int main(int argc, char **argv) {
+	int cases = argc > 1 ? atoi(argv[1]) : 200;
+	uint64_t first_seed = argc > 2 ? strtoull(argv[2], NULL, 0) : 1;
+
+	int flags = MAP_PRIVATE | MAP_ANONYMOUS;
+#ifdef MAP_32BIT
+	flags |= MAP_32BIT;
+#endif
+
+	arena = mmap(NULL, ARENA_SIZE, PROT_READ | PROT_WRITE, flags, -1, 0);
+
+	if (arena == MAP_FAILED || addr(arena) < 0x100000 || addr(arena) + ARENA_SIZE > 0x100000000) {
+		fprintf(stderr, "Could not map an arena below 4 GiB\n");
+		return 1;
+	}
+
+	// Shared with the children, which report back through it
+	struct case_result *result = mmap(NULL, sizeof(*result), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+
+	if (result == MAP_FAILED) {
+		perror("mmap");
+		return 1;
+	}
+
+	int failed = 0;
+	uint64_t ns = 0;
+	uint64_t total_entries = 0;
+
+	for (int i = 0; i < cases; i++) {
+		uint64_t seed = first_seed + i;
+
+		if (fork_case(seed, 0, result) != 0) {
+			failed++;
+			continue;
+		}
+
+		ns += result->ns;
+		total_entries += result->entries;
+	}
+
+	printf("mb2test: %d/%d cases passed", cases - failed, cases);
+
+	if (total_entries != 0) {
+		printf(", %.1f ns per entry", (double)ns / total_entries);
+	}
+
+	printf("\n");
+
+	// Time the parse as the map grows, taking the best of a few runs
+	double first = 0;
+	double last = 0;
+
+	for (int entries = 500; entries <= 8000; entries *= 2) {
+		uint64_t best = UINT64_MAX;
+
+		for (int run = 0; run < PERF_RUNS; run++) {
+			if (fork_case(first_seed + run, entries, result) != 0) {
+				failed++;
+				break;
+			}
+
+			best = result->ns < best ? result->ns : best;
+		}
+
+		if (best == UINT64_MAX) {
+			continue;
+		}
+
+		double per_entry = (double)best / entries;
+		printf("mb2test: %5d entries: %10"PRIu64" ns, %.1f ns per entry\n", entries, best, per_entry);
+
+		first = first == 0 ? per_entry : first;
+		last = per_entry;
+	}
+
+	if (last > first * PERF_MAX_GROWTH) {
+		printf("mb2test: per entry time grew %.1fx, parsing is no longer linear\n", last / first);
+		failed++;
+	}
+
+	return failed == 0 ? 0 : 1;
+}
@@ -0,0 +1,289 @@
+/**
+ * @file mmaptest.c
+ *
+ * @author awewsomegamer <awewsomegamer@gmail.com>
+ *
+ * @LICENSE
+ * Arctan-OS/BSP-GRUB - GRUB bootstrapper for Arctan-OS/Kernel
+ * Copyright (C) 2023-2025 awewsomegamer
+ *
+ * This file is part of Arctan-OS/BSP-GRUB
+ *
+ * Arctan is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 2
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ * @DESCRIPTION
+ * Host test comparing mmap_normalize against a simple reference.
+ * 
+ * The reference resolves every span between two boundaries by scanning
+ * all ranges, which is obviously correct but quadratic. Random maps with
+ * overlaps, shared boundaries, empty and wrapping ranges, unknown types
+ * and overlays must normalise to byte-identical output, and a map one
+ * entry too small must be refused without writing past its end.
+ * 
+ * Usage: mmaptest [cases] [first seed]
+*/
+#include "host.h"
+#include <inttypes.h>
+#include <mm/mmap.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MAX_RANGES 1000
+#define MAX_OVERLAYS 40
+
+// Number of types mmap_normalize tracks, keep in sync with src/c/mm/mmap.c
+#define REF_TYPE_COUNT 32
+
+// Written past the capacity of the map to catch overruns
+#define GUARD_ENTRIES 4
+#define GUARD_BYTE 0xA5
+
+static int cmp_u64(const void *a, const void *b) {
+	uint64_t x = *(const uint64_t *)a;
+	uint64_t y = *(const uint64_t *)b;
+
+	return (x > y) - (x < y);
+}
+
+static int ref_usable(struct ARC_MMap *r) {
+	return r->len != 0 && r->base + r->len >= r->base;
+}
+
+static uint32_t ref_type(struct ARC_MMap *r) {
+	return r->type < REF_TYPE_COUNT ? r->type : ARC_MEMORY_RESERVED;
+}
+
+static int ref_covers(struct ARC_MMap *r, uint64_t base, uint64_t end) {
+	return ref_usable(r) && r->base <= base && r->base + r->len >= end;
+}
+
+/**
+ * Normalise by brute force.
+ *
+ * Each span between two consecutive boundaries exists if a firmware
+ * range covers it, and takes the lowest type of every range and overlay
+ * covering it. Neighbouring spans of the same type are merged.
+ * */
+static int ref_normalize(struct ARC_MMap *in, int count, struct ARC_MMap *overlays, int overlay_count, struct ARC_MMap *out) {
+	static uint64_t bounds[2 * (MAX_RANGES + MAX_OVERLAYS)];
+	int bound_count = 0;
+
+	for (int i = 0; i < count; i++) {
+		if (ref_usable(&in[i])) {
+			bounds[bound_count++] = in[i].base;
+			bounds[bound_count++] = in[i].base + in[i].len;
+		}
+	}
+
+	for (int i = 0; i < overlay_count; i++) {
+		if (ref_usable(&overlays[i])) {
+			bounds[bound_count++] = overlays[i].base;
+			bounds[bound_count++] = overlays[i].base + overlays[i].len;
+		}
+	}
+
+	qsort(bounds, bound_count, sizeof(uint64_t), cmp_u64);
+
+	int n = 0;
+
+	for (int i = 0; i + 1 < bound_count; i++) {
+		uint64_t base = bounds[i];
+		uint64_t end = bounds[i + 1];
+
+		if (base == end) {
+			continue;
+		}
+
+		uint32_t type = UINT32_MAX;
+
+		for (int j = 0; j < count; j++) {
+			if (ref_covers(&in[j], base, end) && ref_type(&in[j]) < type) {
+				type = ref_type(&in[j]);
+			}
+		}
+
+		if (type == UINT32_MAX) {
+			continue;
+		}
+
+		for (int j = 0; j < overlay_count; j++) {
+			if (ref_covers(&overlays[j], base, end) && ref_type(&overlays[j]) < type) {
+				type = ref_type(&overlays[j]);
+			}
+		}
+
+		if (n > 0 && out[n - 1].type == type && out[n - 1].base + out[n - 1].len == base) {
+			out[n - 1].len += end - base;
+			continue;
+		}
+
+		out[n].base = base;
+		out[n].len = end - base;
+		out[n].type = type;
+		n++;
+	}
+
+	return n;
+}
+
+static uint32_t rand_type(uint64_t *state) {
+	uint64_t r = host_rand(state) % 16;
+
+	// Mostly known types, some unknown below and above the tracked count
+	if (r < 12) {
+		return r % (ARC_MEMORY_AVAILABLE + 1);
+	}
+
+	return r < 14 ? ARC_MEMORY_AVAILABLE + 1 + host_rand(state) % (REF_TYPE_COUNT - ARC_MEMORY_AVAILABLE - 1)
+		      : REF_TYPE_COUNT + host_rand(state) % 1000;
+}
+
+static void rand_range(uint64_t *state, struct ARC_MMap *r, uint64_t *points, int point_count) {
+	switch (host_rand(state) % 8) {
+		case 0: {
+			// Empty
+			r->base = host_rand(state) % 0x100000000;
+			r->len = 0;
+			break;
+		}
+
+		case 1: {
+			// Wraps past the top of the address space
+			r->base = UINT64_MAX - host_rand(state) % 0x1000;
+			r->len = 0x1000 + host_rand(state) % 0x1000;
+			break;
+		}
+
+		case 2: case 3: case 4: {
+			// Between shared points, so boundaries coincide often
+			uint64_t a = points[host_rand(state) % point_count];
+			uint64_t b = points[host_rand(state) % point_count];
+			r->base = a < b ? a : b;
+			r->len = (a < b ? b : a) - r->base;
+			break;
+		}
+
+		default: {
+			r->base = host_rand(state) % ((uint64_t)1 << (12 + host_rand(state) % 30));
+			r->len = 1 + host_rand(state) % 0x200000;
+			break;
+		}
+	}
+
+	r->type = rand_type(state);
+}
+
+static int run_case(uint64_t seed) {
+	static struct ARC_MMap in[MAX_RANGES];
+	static struct ARC_MMap overlays[MAX_OVERLAYS];
+	static struct ARC_MMap expected[2 * (MAX_RANGES + MAX_OVERLAYS)];
+	static struct ARC_MMap map[2 * (MAX_RANGES + MAX_OVERLAYS) + ARC_MMAP_HEADROOM + GUARD_ENTRIES];
+	static uint8_t scratch[2 * (MAX_RANGES + MAX_OVERLAYS) * 32];
+	uint64_t points[64];
+	uint64_t state = seed;
+
+	int count = host_rand(&state) % (MAX_RANGES + 1);
+	int overlay_count = host_rand(&state) % (MAX_OVERLAYS + 1);
+
+	for (int i = 0; i < 64; i++) {
+		points[i] = host_rand(&state) % 0x10000000;
+	}
+
+	for (int i = 0; i < count; i++) {
+		rand_range(&state, &in[i], points, 64);
+	}
+
+	for (int i = 0; i < overlay_count; i++) {
+		rand_range(&state, &overlays[i], points, 64);
+	}
+
+	if (mmap_scratch_size(count, overlay_count) > sizeof(scratch)) {
+		fprintf(stderr, "seed %"PRIu64": scratch too small\n", seed);
+		return -1;
+	}
+
+	int expected_count = ref_normalize(in, count, overlays, overlay_count, expected);
+	int capacity = mmap_capacity(count, overlay_count);
+
+	memcpy(map, in, count * sizeof(struct ARC_MMap));
+	memset(&map[capacity], GUARD_BYTE, GUARD_ENTRIES * sizeof(struct ARC_MMap));
+
+	int n = mmap_normalize(map, count, capacity, overlays, overlay_count, scratch);
+
+	if (n != expected_count || memcmp(map, expected, n * sizeof(struct ARC_MMap)) != 0) {
+		fprintf(stderr, "seed %"PRIu64": %d ranges, %d overlays: got %d entries, expected %d\n",
+			seed, count, overlay_count, n, expected_count);
+
+		for (int i = 0; i < n && i < expected_count; i++) {
+			if (memcmp(&map[i], &expected[i], sizeof(struct ARC_MMap)) != 0) {
+				fprintf(stderr, "\tfirst difference at %d: 0x%"PRIx64"+0x%"PRIx64" (%d), expected 0x%"PRIx64"+0x%"PRIx64" (%d)\n",
+					i, map[i].base, map[i].len, map[i].type, expected[i].base, expected[i].len, expected[i].type);
+				break;
+			}
+		}
+
+		return -1;
+	}
+
+	// One entry short of what the map needs must fail, without writing
+	// past the end. The input may extend past the capacity, it is read
+	// into the scratch memory before anything is written
+	if (expected_count > 0) {
+		capacity = expected_count - 1;
+		int end = count > capacity ? count : capacity;
+
+		memcpy(map, in, count * sizeof(struct ARC_MMap));
+		memset(&map[end], GUARD_BYTE, GUARD_ENTRIES * sizeof(struct ARC_MMap));
+
+		host_log_quiet = 1;
+		n = mmap_normalize(map, count, capacity, overlays, overlay_count, scratch);
+		host_log_quiet = 0;
+
+		uint8_t *guard = (uint8_t *)&map[end];
+		int overrun = end > capacity && memcmp(&map[capacity], &in[capacity], (end - capacity) * sizeof(struct ARC_MMap)) != 0;
+
+		for (size_t i = 0; i < GUARD_ENTRIES * sizeof(struct ARC_MMap); i++) {
+			overrun |= guard[i] != GUARD_BYTE;
+		}
+
+		if (overrun) {
+			fprintf(stderr, "seed %"PRIu64": wrote past a capacity of %d\n", seed, capacity);
+			return -1;
+		}
+
+		if (n != -1) {
+			fprintf(stderr, "seed %"PRIu64": %d entries fit in a capacity of %d\n", seed, expected_count, capacity);
+			return -1;
+		}
+	}
+
+	return 0;
+}
+
+int main(int argc, char **argv) {
+	int cases = argc > 1 ? atoi(argv[1]) : 2000;
+	uint64_t first_seed = argc > 2 ? strtoull(argv[2], NULL, 0) : 1;
+	int failed = 0;
+
+	for (int i = 0; i < cases; i++) {
+		if (run_case(first_seed + i) != 0) {
+			failed++;
+		}
+	}
+
+	printf("mmaptest: %d/%d cases matched the reference\n", cases - failed, cases);
+
+	return failed == 0 ? 0 : 1;
+}
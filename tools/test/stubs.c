@@ -0,0 +1,95 @@
+/**
+ * @file stubs.c
+ *
+ * @author awewsomegamer <awewsomegamer@gmail.com>
+ *
+ * @LICENSE
+ * Arctan-OS/BSP-GRUB - GRUB bootstrapper for Arctan-OS/Kernel
+ * Copyright (C) 2023-2025 awewsomegamer
+ *
+ * This file is part of Arctan-OS/BSP-GRUB
+ *
+ * Arctan is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 2
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ * @DESCRIPTION
+ * Stand-ins for the parts of the bootstrapper the host tests do not link,
+ * so mb2parse.c, mmap.c, util.c and fb.c can run as ordinary programs.
+*/
+#include "host.h"
+#include <stdarg.h>
+#include <stdio.h>
+
+struct multiboot_tag_module;
+
+struct ARC_KernelMeta Arc_KernelMeta = { 0 };
+struct ARC_BootMeta Arc_BootMeta = { 0 };
+struct ARC_BootTunables Arc_BootTunables = { 0 };
+
+int host_module_count = 0;
+int host_log_count = 0;
+int host_log_quiet = 0;
+
+// The bootstrapper's image as described by linker.ld, page aligned like
+// the real thing
+__asm__(".bss\n"
+	".balign 4096\n"
+	".globl __BOOTSTRAP_START__\n"
+	"__BOOTSTRAP_START__:\n"
+	".skip 0x2000\n"
+	".globl __BOOTSTRAP_END__\n"
+	"__BOOTSTRAP_END__:\n"
+	".text\n");
+
+int printf_(const char *format, ...) {
+	va_list args;
+
+	host_log_count++;
+
+	if (host_log_quiet) {
+		return 0;
+	}
+
+	va_start(args, format);
+	int r = vfprintf(stderr, format, args);
+	va_end(args);
+
+	return r;
+}
+
+void term_set_fg(uint32_t color) {
+	(void)color;
+}
+
+void bootlog_flush() {
+}
+
+void set_term(uint64_t address, int w, int h, int pitch, int bpp) {
+	(void)address;
+	(void)w;
+	(void)h;
+	(void)pitch;
+	(void)bpp;
+}
+
+int cmdline_parse(char *cmdline) {
+	(void)cmdline;
+	return 0;
+}
+
+int module_register(struct multiboot_tag_module *tag) {
+	(void)tag;
+	host_module_count++;
+
+	return ARC_BOOT_MODULE_OTHER;
+}